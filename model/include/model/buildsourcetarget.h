@@ -31,6 +31,16 @@ struct BuildSource
 
 typedef std::shared_ptr<BuildSource> BuildSourcePtr;
 
+#pragma db view object(BuildSource)
+struct BuildSourceFile
+{
+  #pragma db column(BuildSource::file)
+  FileId file;
+
+  #pragma db column(BuildSource::action)
+  std::uint64_t action;
+};
+
 #pragma db object
 struct BuildTarget
 {
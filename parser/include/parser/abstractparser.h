@@ -52,7 +52,18 @@ public:
    * @return Returns true if the parse succeeded, false otherwise.
    */
   virtual bool parse() = 0;
-  
+
+  /**
+   * Computes the data which is aggregated over the whole database (e.g.
+   * statistics served by the plugin's service). This is called after parsing
+   * and after merging partial databases.
+   * @return Returns true if the aggregation succeeded, false otherwise.
+   */
+  virtual bool aggregate()
+  {
+    return true;
+  }
+
 protected:
   ParserContext& _ctx;
 };
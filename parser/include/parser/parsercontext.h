@@ -37,6 +37,13 @@ struct ParserContext
     std::string& compassRoot_,
     po::variables_map& options_);
 
+  /**
+   * This function fills fileStatus with the stored files which have been
+   * modified or deleted since the previous parse. Every stored file is
+   * checked, so this is called only if the project is going to be parsed.
+   */
+  void detectModifiedFiles();
+
   std::shared_ptr<odb::database> db;
   SourceManager& srcMgr;
   std::string& compassRoot;
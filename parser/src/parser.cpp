@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
@@ -81,7 +82,23 @@ po::options_description commandLineArguments()
      "further actions modifying the state of the database.")
     ("incremental-threshold", po::value<int>()->default_value(10),
       "This is a threshold percentage. If the total ratio of changed files "
-      "is greater than this value, full parse is forced instead of incremental parsing.");
+      "is greater than this value, full parse is forced instead of incremental parsing.")
+    ("partition", po::value<int>(),
+      "Splits the compilation databases given by --input into the given "
+      "number of partitions with approximately equal parsing cost, and writes "
+      "them to --partition-dir as compile_commands.<n>.json. No parsing is "
+      "done in this mode. The partitions can be parsed independently (e.g. on "
+      "different hosts) into separate databases, which can be combined by "
+      "--merge.")
+    ("partition-dir", po::value<std::string>()->default_value("."),
+      "Output directory of --partition.")
+    ("merge", po::value<std::vector<std::string>>(),
+      "Connection strings of databases which were created by parsing the "
+      "partitions of the project. Their content is merged into the database "
+      "given by --database: rows with the same ID are stored only once. Only "
+      "the databases are merged, the plugin specific files in the workspace "
+      "directories of the partitions are not. If no --input is given then "
+      "no parsing is done besides merging.");
 
   return desc;
 }
@@ -147,6 +164,132 @@ std::string prepareProjectDir(const po::variables_map& vm_)
   return projDir;
 }
 
+/**
+ * This function splits the compilation databases among the inputs into the
+ * given number of partitions and writes them to the partition directory. The
+ * build commands are distributed greedily, the largest source file first,
+ * always to the partition with the smallest total size so far.
+ * @return Whether the partitions could be written.
+ */
+bool partitionInput(const po::variables_map& vm_)
+{
+  namespace pt = boost::property_tree;
+
+  int count = vm_["partition"].as<int>();
+
+  if (count < 1)
+  {
+    LOG(error) << "The number of partitions must be positive.";
+    return false;
+  }
+
+  if (!vm_.count("input"))
+  {
+    LOG(error) << "No compilation database is given for partitioning.";
+    return false;
+  }
+
+  std::vector<std::pair<std::uintmax_t, pt::ptree>> commands;
+
+  for (const std::string& input
+    : vm_["input"].as<std::vector<std::string>>())
+  {
+    if (!fs::is_regular_file(input))
+    {
+      LOG(warning) << "Only compilation databases can be partitioned, "
+        "skipping: " << input;
+      continue;
+    }
+
+    pt::ptree root;
+
+    try
+    {
+      pt::read_json(input, root);
+    }
+    catch (const pt::json_parser_error& ex)
+    {
+      LOG(error) << "Couldn't read compilation database: " << ex.what();
+      return false;
+    }
+
+    for (const auto& command : root)
+    {
+      fs::path file = command.second.get<std::string>("file", "");
+
+      if (file.is_relative())
+        file = command.second.get<std::string>("directory", "") / file;
+
+      boost::system::error_code ec;
+      std::uintmax_t size = fs::file_size(file, ec);
+
+      commands.emplace_back(ec ? 1 : std::max<std::uintmax_t>(size, 1),
+        command.second);
+    }
+  }
+
+  std::stable_sort(commands.begin(), commands.end(),
+    [](const auto& lhs_, const auto& rhs_) { return lhs_.first > rhs_.first; });
+
+  std::vector<std::vector<const pt::ptree*>> partitions(count);
+  std::vector<std::uintmax_t> loads(count, 0);
+
+  for (const auto& command : commands)
+  {
+    std::size_t index
+      = std::min_element(loads.begin(), loads.end()) - loads.begin();
+
+    loads[index] += command.first;
+    partitions[index].push_back(&command.second);
+  }
+
+  const std::string partitionDir = vm_["partition-dir"].as<std::string>();
+
+  boost::system::error_code ec;
+  fs::create_directories(partitionDir, ec);
+
+  if (ec)
+  {
+    LOG(error) << "Permission denied to create " + partitionDir;
+    return false;
+  }
+
+  for (int i = 0; i < count; ++i)
+  {
+    if (partitions[i].empty())
+    {
+      LOG(warning) << "Partition " << i << " would be empty, skipping.";
+      continue;
+    }
+
+    const std::string path
+      = partitionDir + "/compile_commands." + std::to_string(i) + ".json";
+
+    // A property tree can't be written as a top-level JSON array, so the
+    // build commands are written one by one.
+    std::ofstream out(path);
+
+    out << '[';
+    for (std::size_t j = 0; j < partitions[i].size(); ++j)
+    {
+      out << (j ? ",\n" : "\n");
+      pt::write_json(out, *partitions[i][j]);
+    }
+    out << "]\n";
+
+    if (!out)
+    {
+      LOG(error) << "Couldn't write partition: " << path;
+      return false;
+    }
+
+    LOG(info) << "Partition " << i << ": " << partitions[i].size()
+      << " build commands written to " << path;
+  }
+
+  return true;
+}
+
 /**
  * Lists the file statuses for added, modified and deleted files affected by
  * incremental parsing.
@@ -205,6 +348,81 @@ void incrementalCleanup(cc::parser::ParserContext& ctx_)
   }
 }
 
+/**
+ * Aggregates the parsed or merged data, and finishes the database and the
+ * project directory.
+ * @param vm_ Command line arguments.
+ * @param pHandler_ Plugin handler of the parsers.
+ * @param db_ The database of the project.
+ * @param isNewDb_ Whether the database has been created by this run.
+ * @param projDir_ Project directory in the workspace.
+ * @return The exit code of the parser.
+ */
+int finishParsing(
+  const po::variables_map& vm_,
+  cc::parser::PluginHandler& pHandler_,
+  std::shared_ptr<odb::database> db_,
+  bool isNewDb_,
+  const std::string& projDir_)
+{
+  //--- Aggregate the parsed or merged data ---//
+
+  for (const std::string& parserName : pHandler_.getTopologicalOrder())
+  {
+    LOG(info) << "[" << parserName << "] aggregation started!";
+    if (!pHandler_.getParser(parserName)->aggregate())
+    {
+      LOG(error) << "[" << parserName << "] aggregation failed!";
+      return 2;
+    }
+  }
+
+  //--- Add indexes to the database ---//
+
+  if (vm_.count("force") || isNewDb_)
+    cc::util::createIndexes(db_, SQL_DIR);
+
+  //--- Create project config file ---//
+
+  boost::property_tree::ptree pt;
+
+  if (vm_.count("label"))
+  {
+    boost::property_tree::ptree labels;
+
+    for (const std::string& label
+      : vm_["label"].as<std::vector<std::string>>())
+    {
+      std::size_t pos = label.find('=');
+
+      if (pos == std::string::npos)
+        LOG(warning)
+          << "Label doesn't contain '=' for separating label and the path: "
+          << label;
+      else
+        labels.put(label.substr(0, pos), label.substr(pos + 1));
+    }
+
+    pt.add_child("labels", labels);
+  }
+
+  std::string database = cc::util::connStrComponent(
+    vm_["database"].as<std::string>(), "database");
+
+  pt.put(
+    "database",
+    database.empty() ? vm_["name"].as<std::string>() : database);
+
+  if (vm_.count("description"))
+    pt.put("description", vm_["description"].as<std::string>());
+
+  boost::property_tree::write_json(projDir_ + "/project_info.json", pt);
+
+  // TODO: Print statistics.
+
+  return 0;
+}
+
 int main(int argc, char* argv[])
 {
   std::string compassRoot = cc::util::binaryPathToInstallDir(argv[0]);
@@ -268,6 +486,9 @@ int main(int argc, char* argv[])
     return 0;
   }
 
+  if (vm.count("partition"))
+    return partitionInput(vm) ? 0 : 1;
+
   try
   {
     po::notify(vm);
@@ -332,6 +553,18 @@ int main(int argc, char* argv[])
   if (vm.count("force") || isNewDb)
     cc::util::createTables(db, SQL_DIR);
 
+  //--- Merge partial databases ---//
+
+  if (vm.count("merge"))
+    for (const std::string& connStr
+      : vm["merge"].as<std::vector<std::string>>())
+    {
+      LOG(info) << "Merging database: " << connStr;
+
+      if (!cc::util::mergeDatabase(db, connStr, SQL_DIR))
+        return 1;
+    }
+
   //--- Start parsers ---//
 
   /*
@@ -349,6 +582,12 @@ int main(int argc, char* argv[])
   cc::parser::ParserContext ctx(db, srcMgr, compassRoot, vm);
   pHandler.createPlugins(ctx);
 
+  // Merging without input only aggregates the merged data.
+  if (vm.count("merge") && !vm.count("input"))
+    return finishParsing(vm, pHandler, db, isNewDb, projDir);
+
+  ctx.detectModifiedFiles();
+
   std::vector<std::string> topologicalOrder = pHandler.getTopologicalOrder();
   for (auto it = topologicalOrder.rbegin(); it != topologicalOrder.rend(); ++it)
   {
@@ -391,47 +630,5 @@ int main(int argc, char* argv[])
     pHandler.getParser(parserName)->parse();
   }
 
-  //--- Add indexes to the database ---//
-
-  if (vm.count("force") || isNewDb)
-    cc::util::createIndexes(db, SQL_DIR);
-
-  //--- Create project config file ---//
-
-  boost::property_tree::ptree pt;
-
-  if (vm.count("label"))
-  {
-    boost::property_tree::ptree labels;
-
-    for (const std::string& label : vm["label"].as<std::vector<std::string>>())
-    {
-      std::size_t pos = label.find('=');
-
-      if (pos == std::string::npos)
-        LOG(warning)
-          << "Label doesn't contain '=' for separating label and the path: "
-          << label;
-      else
-        labels.put(label.substr(0, pos), label.substr(pos + 1));
-    }
-
-    pt.add_child("labels", labels);
-  }
-
-  std::string database
-    = cc::util::connStrComponent(vm["database"].as<std::string>(), "database");
-
-  pt.put(
-    "database",
-    database.empty() ? vm["name"].as<std::string>() : database);
-
-  if (vm.count("description"))
-    pt.put("description", vm["description"].as<std::string>());
-
-  boost::property_tree::write_json(projDir + "/project_info.json", pt);
-
-  // TODO: Print statistics.
-
-  return 0;
+  return finishParsing(vm, pHandler, db, isNewDb, projDir);
 }
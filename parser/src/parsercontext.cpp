@@ -1,4 +1,7 @@
+#include <algorithm>
+#include <ctime>
 #include <fstream>
+#include <mutex>
 
 #include <boost/filesystem.hpp>
 
@@ -6,12 +9,15 @@
 #include <model/file-odb.hxx>
 
 #include <util/hash.h>
+#include <util/logutil.h>
 #include <util/odbtransaction.h>
+#include <util/threadpool.h>
 
 #include <parser/parsercontext.h>
 #include <parser/sourcemanager.h>
 
 namespace po = boost::program_options;
+namespace fs = boost::filesystem;
 
 namespace cc
 {
@@ -28,55 +34,89 @@ ParserContext::ParserContext(
     compassRoot(compassRoot_),
     options(options_)
 {
-  std::unordered_map<std::string, std::string> fileHashes;
+}
 
-  (util::OdbTransaction(this->db))([&]
-   {
-     // Fetch directory and binary type files from SourceManager
-     auto func = [](model::FilePtr item)
-     {
-       return item->type != model::File::DIRECTORY_TYPE &&
-              item->type != model::File::BINARY_TYPE;
-     };
-     std::vector<model::FilePtr> files = this->srcMgr.getFiles(func);
+void ParserContext::detectModifiedFiles()
+{
+  // Fetch directory and binary type files from SourceManager
+  auto func = [](model::FilePtr item)
+  {
+    return item->type != model::File::DIRECTORY_TYPE &&
+           item->type != model::File::BINARY_TYPE;
+  };
+  std::vector<model::FilePtr> files = this->srcMgr.getFiles(func);
+
+  // Files whose modification time changed but their content didn't. Their
+  // timestamp is refreshed, so they are not hashed again at the next run.
+  std::vector<model::FilePtr> touchedFiles;
+  std::mutex mutex;
+
+  // The files are checked in parallel. Only the files whose modification time
+  // differs from the stored one are read and hashed. The stored hash is the ID
+  // of the file content, so the content itself is not loaded.
+  auto checkFile = [&, this](model::FilePtr file_)
+  {
+    boost::system::error_code ec;
+
+    if (!fs::exists(file_->path, ec))
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      fileStatus.emplace(file_->path, IncrementalStatus::DELETED);
+      LOG(debug) << "File deleted: " << file_->path;
+      return;
+    }
+
+    if (!file_->content)
+      return;
+
+    std::time_t timestamp = fs::last_write_time(file_->path, ec);
+    if (!ec && static_cast<std::uint64_t>(timestamp) == file_->timestamp)
+      return;
+
+    std::ifstream fileStream(file_->path);
+    std::string fileContent(
+      std::istreambuf_iterator<char>{fileStream},
+      std::istreambuf_iterator<char>{});
+    fileStream.close();
+
+    bool modified = file_->content.object_id() != util::sha1Hash(fileContent);
 
-     for (model::FilePtr file : files)
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (modified)
+    {
+      fileStatus.emplace(file_->path, IncrementalStatus::MODIFIED);
+      LOG(debug) << "File modified: " << file_->path;
+    }
+    else if (!ec)
+    {
+      file_->timestamp = timestamp;
+      touchedFiles.push_back(file_);
+    }
+  };
+
+  int threadNum = options.count("jobs") ? options["jobs"].as<int>() : 1;
+
+  std::unique_ptr<util::JobQueueThreadPool<model::FilePtr>> pool =
+    util::make_thread_pool<model::FilePtr>(
+      std::max(threadNum, 1), checkFile);
+
+  for (model::FilePtr file : files)
+    pool->enqueue(file);
+
+  pool->wait();
+
+  if (!touchedFiles.empty())
+    (util::OdbTransaction(this->db))([&]
      {
-       if (boost::filesystem::exists(file->path))
-       {
-         if (!fileStatus.count(file->path))
-         {
-           model::FileContentPtr content = file->content.load();
-           if (!content)
-             continue;
-
-           fileHashes[file->path] = content->hash;
-
-           std::ifstream fileStream(file->path);
-           std::string fileContent(
-             std::istreambuf_iterator<char>{fileStream},
-             std::istreambuf_iterator<char>{});
-           fileStream.close();
-
-           if (content->hash != util::sha1Hash(fileContent))
-           {
-             this->fileStatus.emplace(
-               file->path, cc::parser::IncrementalStatus::MODIFIED);
-             LOG(debug) << "File modified: " << file->path;
-           }
-         }
-       }
-       else
-       {
-         fileStatus.emplace(
-           file->path, cc::parser::IncrementalStatus::DELETED);
-         LOG(debug) << "File deleted: " << file->path;
-       }
-     }
-
-     // TODO: detect ADDED files
-   });
+       for (const model::FilePtr& file : touchedFiles)
+         this->db->update(*file);
+     });
+
+  // The added files are detected by the parser plugins in markModifiedFiles(),
+  // because only the plugins know which files of their input they parse (e.g.
+  // the source files of a compilation database).
 }
+
 }
 }
-
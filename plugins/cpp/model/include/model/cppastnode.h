@@ -20,7 +20,7 @@ namespace model
 
 typedef std::uint64_t CppAstNodeId;
 
-#pragma db object
+#pragma db object bulk(5000)
 struct CppAstNode
 {
   enum class SymbolType
@@ -16,7 +16,7 @@ namespace model
 
 typedef std::uint64_t CppEdgeId;
 
-#pragma db object
+#pragma db object bulk(5000)
 struct CppEdge
 {
   /**
@@ -88,7 +88,7 @@ inline std::uint64_t createIdentifier(const CppEdge& edge_)
 
 typedef std::uint64_t CppEdgeAttributeId;
 
-#pragma db object
+#pragma db object bulk(5000)
 struct CppEdgeAttribute
 {
   #pragma db id
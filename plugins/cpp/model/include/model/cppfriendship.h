@@ -8,7 +8,7 @@ namespace cc
 namespace model
 {
 
-#pragma db object
+#pragma db object bulk(5000)
 struct CppFriendship
 {
   #pragma db id auto
@@ -14,7 +14,7 @@ namespace cc
 namespace model
 {
 
-#pragma db object
+#pragma db object bulk(5000)
 struct CppHeaderInclusion
 {
   #pragma db id auto
@@ -42,6 +42,34 @@ struct CppHeaderInclusion
 
 typedef std::shared_ptr<CppHeaderInclusion> CppHeaderInclusionPtr;
 
+#pragma db view \
+  object(CppHeaderInclusion) \
+  object(File = Includer : CppHeaderInclusion::includer) \
+  query ((?) + "GROUP BY" + Includer::id)
+struct CppHeaderInclusionCountByIncluder
+{
+  #pragma db column(Includer::id)
+  FileId includer;
+
+  #pragma db column("count(" + CppHeaderInclusion::id + ")")
+  std::size_t count;
+};
+
+#pragma db view \
+  object(CppHeaderInclusion) \
+  object(File = Includer : CppHeaderInclusion::includer)
+struct CppHeaderInclusionPath
+{
+  #pragma db column(Includer::id)
+  FileId includer;
+
+  #pragma db column(Includer::path)
+  std::string includerPath;
+
+  #pragma db column(CppHeaderInclusion::included)
+  FileId included;
+};
+
 } // model
 } // cc
 
@@ -9,7 +9,7 @@ namespace cc
 namespace model
 {
 
-#pragma db object
+#pragma db object bulk(5000)
 struct CppInheritance
 {
   #pragma db id auto
@@ -14,7 +14,7 @@ namespace cc
 namespace model
 {
 
-#pragma db object
+#pragma db object bulk(5000)
 struct CppMacroExpansion
 {
   #pragma db id auto
@@ -37,6 +37,8 @@ struct CppMacroExpansion
 
     return ret;
   }
+
+#pragma db index member(astNodeId)
 };
 
 typedef std::shared_ptr<CppMacroExpansion> CppMacroExpansionPtr;
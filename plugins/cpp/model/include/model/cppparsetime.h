@@ -0,0 +1,51 @@
+#ifndef CC_MODEL_CPPPARSETIME_H
+#define CC_MODEL_CPPPARSETIME_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <odb/core.hxx>
+
+#include <model/file.h>
+
+namespace cc
+{
+namespace model
+{
+
+/**
+ * The duration of parsing a translation unit in the last parser run. The C++
+ * parser uses this to start the most expensive translation units first in the
+ * next (incremental) run.
+ */
+#pragma db object
+struct CppParseTime
+{
+  /**
+   * The ID of the translation unit's main source file. This is not a reference
+   * to the model::File object, because the timing has to survive the removal
+   * of the file during incremental parsing.
+   */
+  #pragma db id
+  FileId file;
+
+  /**
+   * Parse duration in milliseconds.
+   */
+  std::uint64_t duration;
+
+  std::string toString() const
+  {
+    return std::string("CppParseTime")
+      .append("\nfile = ").append(std::to_string(file))
+      .append("\nduration = ").append(std::to_string(duration));
+  }
+};
+
+typedef std::shared_ptr<CppParseTime> CppParseTimePtr;
+
+} // model
+} // cc
+
+#endif // CC_MODEL_CPPPARSETIME_H
@@ -0,0 +1,88 @@
+#ifndef CC_MODEL_CPPREFERENCECOUNT_H
+#define CC_MODEL_CPPREFERENCECOUNT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <odb/core.hxx>
+
+namespace cc
+{
+namespace model
+{
+
+/**
+ * The number of references of a symbol by reference kind. These are computed
+ * by the C++ parser after the whole project has been parsed, so the service
+ * doesn't have to count the AST nodes each time the info tree of a symbol is
+ * opened.
+ */
+#pragma db object bulk(5000)
+struct CppReferenceCount
+{
+  #pragma db id
+  std::uint64_t mangledNameHash;
+
+  std::size_t definition = 0;
+  std::size_t declaration = 0;
+  std::size_t usage = 0;
+  std::size_t callsOfThis = 0;
+  std::size_t caller = 0;
+  std::size_t read = 0;
+  std::size_t write = 0;
+  std::size_t undefinition = 0;
+  std::size_t overrides = 0;
+  std::size_t overriddenBy = 0;
+
+  std::string toString() const
+  {
+    return std::string("CppReferenceCount")
+      .append("\nmangledNameHash = ").append(std::to_string(mangledNameHash))
+      .append("\ndefinition = ").append(std::to_string(definition))
+      .append("\ndeclaration = ").append(std::to_string(declaration))
+      .append("\nusage = ").append(std::to_string(usage))
+      .append("\ncallsOfThis = ").append(std::to_string(callsOfThis))
+      .append("\ncaller = ").append(std::to_string(caller))
+      .append("\nread = ").append(std::to_string(read))
+      .append("\nwrite = ").append(std::to_string(write))
+      .append("\nundefinition = ").append(std::to_string(undefinition))
+      .append("\noverrides = ").append(std::to_string(overrides))
+      .append("\noverriddenBy = ").append(std::to_string(overriddenBy));
+  }
+};
+
+typedef std::shared_ptr<CppReferenceCount> CppReferenceCountPtr;
+
+/**
+ * Result of the native query which counts the AST nodes of the symbols by AST
+ * type. The columns are in the order of the data members.
+ */
+#pragma db view
+struct CppAstNodeCountByType
+{
+  std::uint64_t mangledNameHash;
+  std::size_t definition;
+  std::size_t declaration;
+  std::size_t usage;
+  std::size_t callsOfThis;
+  std::size_t read;
+  std::size_t write;
+  std::size_t undefinition;
+};
+
+/**
+ * Result of a native query which counts something per symbol.
+ */
+#pragma db view
+struct CppSymbolCount
+{
+  std::uint64_t mangledNameHash;
+  std::size_t count;
+};
+
+} // model
+} // cc
+
+#endif // CC_MODEL_CPPREFERENCECOUNT_H
@@ -1,14 +1,16 @@
 #ifndef CC_MODEL_CPPRELATION_H
 #define CC_MODEL_CPPRELATION_H
 
+#include <cstdint>
 #include <memory>
+#include <string>
 
 namespace cc
 {
 namespace model
 {
 
-#pragma db object
+#pragma db object bulk(5000)
 struct CppRelation
 {
   enum class Kind
@@ -44,6 +46,16 @@ struct CppRelation
 
 typedef std::shared_ptr<CppRelation> CppRelationPtr;
 
+/**
+ * Result of a native query which lists the nodes reachable from a node through
+ * CppRelation edges (see CppServiceHandler::transitiveClosureOfRel()).
+ */
+#pragma db view
+struct CppRelationClosure
+{
+  std::uint64_t node;
+};
+
 #pragma db view object(CppRelation)
 struct CppRelationCount
 {
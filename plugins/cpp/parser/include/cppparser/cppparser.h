@@ -2,7 +2,9 @@
 #define CC_PARSER_CXXPARSER_H
 
 #include <map>
+#include <memory>
 #include <set>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -10,6 +12,11 @@
 #include <clang/Tooling/Tooling.h>
 
 #include <model/buildaction.h>
+#include <model/cppastnode.h>
+#include <model/cppedge.h>
+#include <model/cppheaderinclusion.h>
+#include <model/cpptype.h>
+#include <model/file.h>
 
 #include <parser/abstractparser.h>
 #include <parser/parsercontext.h>
@@ -18,6 +25,8 @@ namespace cc
 {
 namespace parser
 {
+
+class PreambleCache;
   
 class CppParser : public AbstractParser
 {
@@ -38,6 +47,13 @@ public:
    */
   virtual bool cleanupDatabase() override;
   virtual bool parse() override;
+  /**
+   * Computes the reference counts of the symbols (see ReferenceCounter), which
+   * are served by the C++ service instead of counting the references on each
+   * request. After an incremental parse only the symbols of the changed files
+   * are counted again.
+   */
+  virtual bool aggregate() override;
 
 private:
   /**
@@ -106,14 +122,129 @@ private:
   bool isNonSourceFlag(const std::string& arg_) const;
   bool parseByJson(const std::string& jsonFile_, std::size_t threadNum_);
   int parseWorker(const clang::tooling::CompileCommand& command_);
+
+  /**
+   * This function estimates the parsing cost of the given compile commands in
+   * milliseconds. If a translation unit was parsed in a previous run then its
+   * recorded parse duration is used. Otherwise the cost is estimated from the
+   * size of the source file and the number of its header inclusions known from
+   * the previous run.
+   */
+  std::vector<std::uint64_t> estimateParseCosts(
+    const std::vector<clang::tooling::CompileCommand>& commands_);
+
+  /**
+   * This function stores the parse durations of the translation units so
+   * that the next run can schedule them by cost.
+   * @param parseTimes_ Parse durations in milliseconds by the file ID of the
+   * translation units' source file.
+   */
+  void persistParseTimes(
+    const std::unordered_map<model::FileId, std::uint64_t>& parseTimes_);
   
   void initBuildActions();
-  void markByInclusion(model::FilePtr file_);
+
+  /**
+   * This function compares the compile commands of the input compilation
+   * databases with the build actions of the previous parse. The source files
+   * which have no build action yet are marked as added, the ones compiled
+   * with a changed command are marked as modified. The compile commands of
+   * the unchanged source files are skipped by parseByJson(), so only the
+   * added and modified translation units are parsed again.
+   */
+  void markByCompileCommands();
+
+  /**
+   * This function loads the header inclusions of the previous parse into
+   * memory by a single query. The graph is used both for marking the
+   * includers of the changed files and for ordering their cleanup.
+   */
+  void loadInclusionGraph();
+
+  /**
+   * This function marks the files which include a modified or deleted file,
+   * directly or transitively, as modified.
+   *
+   * If only the comments of a header changed and its tokens are at the same
+   * positions then the data of the header and of its includers are still
+   * valid. The includers of such a header are not marked.
+   */
+  void markByInclusion();
+
+  /**
+   * This function marks the includers of the files in the stack, directly or
+   * transitively, as modified. The visited files are not marked again.
+   */
+  void markIncluders(
+    std::vector<model::FileId>& stack_,
+    std::unordered_set<model::FileId>& visited_);
+
+  /**
+   * This function returns true if the content of the file on the disk differs
+   * from the stored one only in its ordinary comments and in the whitespace at
+   * the end of the lines, so all of its tokens are at the same position.
+   */
+  bool hasSameCode(const std::string& path_);
+
+  /**
+   * The file of a modified header is deleted at the cleanup together with its
+   * AST nodes, inclusions and file edges. These functions keep the data of the
+   * headers in _sameCodeHeaders, except for the references to the files which
+   * are parsed again, and persist them again before parsing.
+   */
+  void keepUnchangedHeaders();
+  void restoreUnchangedHeaders();
   std::vector<std::vector<std::string>> createCleanupOrder();
   bool cleanupWorker(const std::string& path_);
 
   std::unordered_set<std::uint64_t> _parsedCommandHashes;
 
+  /**
+   * The includers of the files by the ID of the included file, and the paths
+   * of the includers (see loadInclusionGraph()).
+   */
+  std::unordered_map<model::FileId, std::vector<model::FileId>> _includers;
+  std::unordered_map<model::FileId, std::string> _includerPaths;
+
+  /**
+   * Modified headers whose tokens didn't change, so they are not indexed
+   * again (see markByInclusion()), and their data kept through the cleanup.
+   */
+  std::unordered_set<model::FileId> _sameCodeHeaders;
+  std::vector<model::FilePtr> _keptFiles;
+  std::vector<model::CppAstNodePtr> _keptAstNodes;
+  std::vector<model::CppMemberTypePtr> _keptMemberTypes;
+  std::vector<model::CppHeaderInclusionPtr> _keptInclusions;
+  std::vector<model::CppEdgePtr> _keptEdges;
+  std::vector<model::CppEdgeAttributePtr> _keptEdgeAttributes;
+
+  /**
+   * This function returns the IDs of the files which are modified, added or
+   * deleted by the incremental parsing. Before parsing these are the files of
+   * the file status, after parsing also the newly stored files.
+   */
+  std::vector<model::FileId> changedFiles() const;
+
+  /**
+   * The symbols which have AST nodes in the changed files before or after an
+   * incremental parsing. Only the reference counts of these are computed
+   * again (see aggregate()).
+   */
+  std::unordered_set<std::uint64_t> _changedSymbols;
+  std::unordered_set<model::FileId> _prevFiles;
+  bool _countChangedSymbols = false;
+
+  /**
+   * Parse durations recorded in the previous run by source file ID.
+   */
+  std::unordered_map<model::FileId, std::uint64_t> _prevParseTimes;
+
+  /**
+   * Precompiled preambles shared by translation units. This is set only if
+   * the reuse-preamble option is given.
+   */
+  std::unique_ptr<PreambleCache> _preambleCache;
+
 };
   
 } // parser
@@ -5,6 +5,7 @@
 #include <mutex>
 #include <type_traits>
 #include <stack>
+#include <vector>
 
 #include <clang/Basic/SourceLocation.h>
 #include <clang/Basic/SourceManager.h>
@@ -39,7 +40,10 @@
 
 #include <cppparser/filelocutil.h>
 
+#include "indexedheaders.h"
 #include "manglednamecache.h"
+#include "objectpool.h"
+#include "pptranscriptcallback.h"
 #include "symbolhelper.h"
 
 namespace cc
@@ -63,6 +67,14 @@ namespace parser
  * parameters and local variables of the function find their parent at the top
  * of the stack. If stack is used then they are pushed and popped in the
  * corresponding Traverse... function.
+ *
+ * The declarations of a header which has already been visited in another
+ * translation unit with the same preprocessor transcript are skipped, since
+ * they would produce the same AST nodes again (see IndexedHeaders).
+ *
+ * The collected objects are persisted in the destructor. If a memory limit is
+ * given by the visitor-memory-limit option then they are also persisted
+ * during the traversal whenever their approximate size exceeds the limit.
  */
 class ClangASTVisitor : public clang::RecursiveASTVisitor<ClangASTVisitor>
 {
@@ -71,7 +83,9 @@ public:
     ParserContext& ctx_,
     clang::ASTContext& astContext_,
     MangledNameCache& mangledNameCache_,
-    std::unordered_map<const void*, model::CppAstNodeId>& clangToAstNodeId_)
+    std::unordered_map<const void*, model::CppAstNodeId>& clangToAstNodeId_,
+    IndexedHeaders& indexedHeaders_,
+    const HeaderTranscripts& headerTranscripts_)
     : _isImplicit(false),
       _ctx(ctx_),
       _clangSrcMgr(astContext_.getSourceManager()),
@@ -80,43 +94,28 @@ public:
       _mngCtx(astContext_.createMangleContext()),
       _cppSourceType("CPP"),
       _mangledNameCache(mangledNameCache_),
-      _clangToAstNodeId(clangToAstNodeId_)
+      _clangToAstNodeId(clangToAstNodeId_),
+      _indexedHeaders(indexedHeaders_),
+      _headerTranscripts(headerTranscripts_),
+      _memoryLimit(ctx_.options.count("visitor-memory-limit")
+        ? ctx_.options["visitor-memory-limit"].as<std::size_t>() << 20
+        : 0),
+      _measuredAstNodes(0),
+      _astNodeBytes(0),
+      _typeLocBytes(0),
+      _retainedBytes(0)
   {
   }
 
   ~ClangASTVisitor()
   {
-    _ctx.srcMgr.persistFiles();
-
-    for (auto& p : _locToTypeLoc)
-    {
-      model::CppAstNodePtr typeLocAstNode = p.second;
-
-      auto it = _locToAstType.find(p.first);
-
-      if (it != _locToAstType.end())
-        typeLocAstNode->astType = it->second;
-
-      typeLocAstNode->id = createIdentifier(*typeLocAstNode);
+    persistCollected();
 
-      if (insertToCache(0, typeLocAstNode))
-        _astNodes.push_back(typeLocAstNode);
-    }
-
-    (util::OdbTransaction(_ctx.db))([this]{
-      util::persistAll(_astNodes, _ctx.db);
-      util::persistAll(_enumConstants, _ctx.db);
-      util::persistAll(_enums, _ctx.db);
-      util::persistAll(_types, _ctx.db);
-      util::persistAll(_typedefs, _ctx.db);
-      util::persistAll(_variables, _ctx.db);
-      util::persistAll(_namespaces, _ctx.db);
-      util::persistAll(_members, _ctx.db);
-      util::persistAll(_inheritances, _ctx.db);
-      util::persistAll(_friends, _ctx.db);
-      util::persistAll(_functions, _ctx.db);
-      util::persistAll(_relations, _ctx.db);
-    });
+    // If the translation unit has errors then its AST may be incomplete, so
+    // the headers have to be visited again in other translation units.
+    if (!_astContext.getDiagnostics().hasErrorOccurred())
+      for (const auto& transcript : _headerTranscripts)
+        _indexedHeaders.insert(transcript.second);
   }
 
   bool shouldVisitImplicitCode() const { return true; }
@@ -124,6 +123,12 @@ public:
 
   bool TraverseDecl(clang::Decl* decl_)
   {
+    if (decl_ && isIndexedHeaderDecl(decl_))
+    {
+      traverseImplicitMembers(decl_);
+      return true;
+    }
+
     bool prevIsImplicit = _isImplicit;
 
     if (decl_)
@@ -133,6 +138,9 @@ public:
 
     _isImplicit = prevIsImplicit;
 
+    if (_memoryLimit && collectedBytes() >= _memoryLimit + _retainedBytes)
+      persistCollected();
+
     return b;
   }
 
@@ -284,7 +292,7 @@ public:
 
     const clang::TypedefNameDecl* td = type->getDecl();
 
-    model::CppAstNodePtr astNode = std::make_shared<model::CppAstNode>();
+    model::CppAstNodePtr astNode = createAstNode();
 
     astNode->location = getFileLoc(tl_.getLocStart(), tl_.getLocEnd());
     astNode->astType = model::CppAstNode::AstType::TypeLocation;
@@ -293,7 +301,7 @@ public:
     astNode->symbolType = model::CppAstNode::SymbolType::Typedef;
     astNode->mangledNameHash = util::fnvHash(astNode->mangledName);
 
-    _locToTypeLoc[tl_.getLocStart().getRawEncoding()] = astNode;
+    addTypeLoc(tl_, astNode);
 
     return true;
   }
@@ -305,7 +313,7 @@ public:
 
     const clang::EnumDecl* ed = type->getDecl();
 
-    model::CppAstNodePtr astNode = std::make_shared<model::CppAstNode>();
+    model::CppAstNodePtr astNode = createAstNode();
 
     astNode->location = getFileLoc(tl_.getLocStart(), tl_.getLocEnd());
     astNode->astType = model::CppAstNode::AstType::TypeLocation;
@@ -314,7 +322,7 @@ public:
     astNode->symbolType = model::CppAstNode::SymbolType::Enum;
     astNode->mangledNameHash = util::fnvHash(astNode->mangledName);
 
-    _locToTypeLoc[tl_.getLocStart().getRawEncoding()] = astNode;
+    addTypeLoc(tl_, astNode);
 
     return true;
   }
@@ -326,7 +334,7 @@ public:
 
     const clang::RecordDecl* rd = type->getDecl();
 
-    model::CppAstNodePtr astNode = std::make_shared<model::CppAstNode>();
+    model::CppAstNodePtr astNode = createAstNode();
 
     astNode->location = getFileLoc(tl_.getLocStart(), tl_.getLocEnd());
     astNode->astType = model::CppAstNode::AstType::TypeLocation;
@@ -335,7 +343,7 @@ public:
     astNode->symbolType = model::CppAstNode::SymbolType::Type;
     astNode->mangledNameHash = util::fnvHash(astNode->mangledName);
 
-    _locToTypeLoc[tl_.getLocStart().getRawEncoding()] = astNode;
+    addTypeLoc(tl_, astNode);
 
     return true;
   }
@@ -351,7 +359,7 @@ public:
 
     //--- CppAstNode ---//
 
-    model::CppAstNodePtr astNode = std::make_shared<model::CppAstNode>();
+    model::CppAstNodePtr astNode = createAstNode();
 
     astNode->astValue = rd_->getNameAsString();
     astNode->location = getFileLoc(rd_->getLocStart(), rd_->getLocEnd());
@@ -464,7 +472,7 @@ public:
   {
     //--- CppAstNode ---//
 
-    model::CppAstNodePtr astNode = std::make_shared<model::CppAstNode>();
+    model::CppAstNodePtr astNode = createAstNode();
 
     astNode->astValue = ed_->getNameAsString();
     astNode->location = getFileLoc(ed_->getLocStart(), ed_->getLocEnd());
@@ -503,7 +511,7 @@ public:
   {
     //--- CppAstNode ---//
 
-    model::CppAstNodePtr astNode = std::make_shared<model::CppAstNode>();
+    model::CppAstNodePtr astNode = createAstNode();
 
     astNode->astValue = ec_->getNameAsString();
     astNode->location = getFileLoc(ec_->getLocStart(), ec_->getLocEnd());
@@ -541,7 +549,7 @@ public:
     //--- CppAstNode ---//
 
     // TODO: Originally mangled name was appended by some suffix. Why?
-    model::CppAstNodePtr astNode = std::make_shared<model::CppAstNode>();
+    model::CppAstNodePtr astNode = createAstNode();
 
     astNode->astValue = td_->getNameAsString();
     astNode->location = getFileLoc(td_->getLocStart(), td_->getLocEnd());
@@ -589,7 +597,7 @@ public:
   {
     //--- CppAstNode ---//
 
-    model::CppAstNodePtr astNode = std::make_shared<model::CppAstNode>();
+    model::CppAstNodePtr astNode = createAstNode();
 
     astNode->astValue = getSignature(fn_);
     astNode->location = getFileLoc(fn_->getLocStart(), fn_->getLocEnd());
@@ -676,7 +684,7 @@ public:
       if (!member || init->getSourceOrder() == -1)
         continue;
 
-      model::CppAstNodePtr astNode = std::make_shared<model::CppAstNode>();
+      model::CppAstNodePtr astNode = createAstNode();
 
       astNode->astValue = getSignature(cd_);
       astNode->location = getFileLoc(
@@ -703,7 +711,7 @@ public:
   {
     //--- CppAstNode ---//
 
-    model::CppAstNodePtr astNode = std::make_shared<model::CppAstNode>();
+    model::CppAstNodePtr astNode = createAstNode();
 
     astNode->astValue = fd_->getNameAsString();
     astNode->location = getFileLoc(fd_->getLocStart(), fd_->getLocEnd());
@@ -761,7 +769,7 @@ public:
   {
     //--- CppAstNode ---//
 
-    model::CppAstNodePtr astNode = std::make_shared<model::CppAstNode>();
+    model::CppAstNodePtr astNode = createAstNode();
 
     astNode->astValue = vd_->getNameAsString();
     astNode->location = getFileLoc(vd_->getLocation(), vd_->getLocation());
@@ -854,7 +862,7 @@ public:
   {
     //--- CppAstNode ---//
 
-    model::CppAstNodePtr astNode = std::make_shared<model::CppAstNode>();
+    model::CppAstNodePtr astNode = createAstNode();
 
     astNode->astValue = nd_->getNameAsString();
     astNode->location = getFileLoc(nd_->getLocStart(), nd_->getLocEnd());
@@ -885,7 +893,7 @@ public:
 
   bool VisitCXXConstructExpr(clang::CXXConstructExpr* ce_)
   {
-    model::CppAstNodePtr astNode = std::make_shared<model::CppAstNode>();
+    model::CppAstNodePtr astNode = createAstNode();
 
     const clang::CXXConstructorDecl* ctor = ce_->getConstructor();
 
@@ -916,7 +924,7 @@ public:
     if (!functionDecl)
       return true;
 
-    model::CppAstNodePtr astNode = std::make_shared<model::CppAstNode>();
+    model::CppAstNodePtr astNode = createAstNode();
 
     astNode->astValue = getSignature(functionDecl);
     astNode->location = getFileLoc(ne_->getLocStart(), ne_->getLocEnd());
@@ -944,7 +952,7 @@ public:
     if (!functionDecl)
       return true;
 
-    model::CppAstNodePtr astNode = std::make_shared<model::CppAstNode>();
+    model::CppAstNodePtr astNode = createAstNode();
 
     astNode->astValue = getSignature(functionDecl);
     astNode->location = getFileLoc(de_->getLocStart(), de_->getLocEnd());
@@ -973,7 +981,7 @@ public:
     const clang::FunctionDecl* funcCallee
       = llvm::dyn_cast<clang::FunctionDecl>(callee);
 
-    model::CppAstNodePtr astNode = std::make_shared<model::CppAstNode>();
+    model::CppAstNodePtr astNode = createAstNode();
 
     astNode->astValue
       = funcCallee
@@ -1007,7 +1015,7 @@ public:
 
     if (const clang::VarDecl* vd = llvm::dyn_cast<clang::VarDecl>(decl))
     {
-      astNode = std::make_shared<model::CppAstNode>();
+      astNode = createAstNode();
 
       model::FileLoc location =
         getFileLoc(vd->getLocation(), vd->getLocation());
@@ -1030,7 +1038,7 @@ public:
     else if (const clang::EnumConstantDecl* ec
       = llvm::dyn_cast<clang::EnumConstantDecl>(decl))
     {
-      astNode = std::make_shared<model::CppAstNode>();
+      astNode = createAstNode();
 
       astNode->astValue = ec->getNameAsString();
       astNode->location = getFileLoc(dr_->getLocStart(), dr_->getLocEnd());
@@ -1056,7 +1064,7 @@ public:
     const clang::CXXMethodDecl* method
       = llvm::dyn_cast<clang::CXXMethodDecl>(vd);
 
-    model::CppAstNodePtr astNode = std::make_shared<model::CppAstNode>();
+    model::CppAstNodePtr astNode = createAstNode();
 
     astNode->astValue = method ? getSignature(method) : vd->getNameAsString();
     astNode->location = getFileLoc(me_->getLocStart(), me_->getLocEnd());
@@ -1087,16 +1095,14 @@ public:
          it != decl->end_overridden_methods();
          ++it)
     {
-      auto left = _clangToAstNodeId.find(decl);
-      auto right = _clangToAstNodeId.find(*it);
-
-      if (left == _clangToAstNodeId.end() || right == _clangToAstNodeId.end())
-        continue;
-
+      // The relation is built from the mangled names instead of the AST
+      // nodes, because the overridden method may be declared in a skipped
+      // header (see isIndexedHeaderDecl()), so it has no AST node in this
+      // translation unit.
       model::CppRelationPtr rel = std::make_shared<model::CppRelation>();
       rel->kind = model::CppRelation::Kind::Override;
-      rel->lhs = _mangledNameCache.at(left->second);
-      rel->rhs = _mangledNameCache.at(right->second);
+      rel->lhs = util::fnvHash(getMangledName(_mngCtx, decl));
+      rel->rhs = util::fnvHash(getMangledName(_mngCtx, *it));
       _relations.push_back(rel);
     }
 
@@ -1104,6 +1110,272 @@ public:
   }
 
 private:
+  /**
+   * This function creates an AST node in the pool of the visitor. The node
+   * and the control block of its shared pointer are allocated together, and
+   * the memory is reused after the node is persisted.
+   */
+  model::CppAstNodePtr createAstNode()
+  {
+    return std::allocate_shared<model::CppAstNode>(
+      PoolAllocator<model::CppAstNode>(_astNodePool));
+  }
+
+  /**
+   * This function persists the collected objects and releases their memory.
+   * The objects referred by others are persisted first, so the referring
+   * objects can store their IDs. The objects under construction are on the
+   * stacks, so they are not affected.
+   */
+  void persistCollected()
+  {
+    collectTypeLocs();
+
+    _ctx.srcMgr.persistFiles();
+
+    (util::OdbTransaction(_ctx.db))([this]{
+      util::persistAll(_astNodes, _ctx.db);
+      util::persistAll(_enumConstants, _ctx.db);
+      util::persistAll(_enums, _ctx.db);
+      util::persistAll(_types, _ctx.db);
+      util::persistAll(_typedefs, _ctx.db);
+      util::persistAll(_variables, _ctx.db);
+      util::persistAll(_namespaces, _ctx.db);
+      util::persistAll(_members, _ctx.db);
+      util::persistAll(_inheritances, _ctx.db);
+      util::persistAll(_friends, _ctx.db);
+      util::persistAll(_functions, _ctx.db);
+      util::persistAll(_relations, _ctx.db);
+    });
+
+    release(_astNodes);
+    release(_enumConstants);
+    release(_enums);
+    release(_types);
+    release(_typedefs);
+    release(_variables);
+    release(_namespaces);
+    release(_members);
+    release(_inheritances);
+    release(_friends);
+    release(_functions);
+    release(_relations);
+
+    _measuredAstNodes = 0;
+    _astNodeBytes = 0;
+
+    // The declarations are looked up by the documentation comment collector
+    // after the visitor, so this map can't be released.
+    _retainedBytes = mapBytes(_clangToAstNodeId);
+  }
+
+  /**
+   * This function records the AST node of a type location. The type of the
+   * node is determined by the declaration using the location (see
+   * _locToAstType), so the node is completed by collectTypeLocs().
+   */
+  void addTypeLoc(const clang::TypeLoc& tl_, model::CppAstNodePtr astNode_)
+  {
+    model::CppAstNodePtr& entry
+      = _locToTypeLoc[tl_.getLocStart().getRawEncoding()];
+
+    if (entry)
+      _typeLocBytes -= nodeBytes(*entry);
+
+    entry = astNode_;
+    _typeLocBytes += nodeBytes(*entry);
+  }
+
+  /**
+   * This function moves the AST nodes of the type locations among the
+   * collected AST nodes. The declarations using a type location are visited
+   * before the location itself, so the type of the nodes is already known
+   * when a declaration has been traversed.
+   */
+  void collectTypeLocs()
+  {
+    for (auto& p : _locToTypeLoc)
+    {
+      model::CppAstNodePtr typeLocAstNode = p.second;
+
+      auto it = _locToAstType.find(p.first);
+
+      if (it != _locToAstType.end())
+        typeLocAstNode->astType = it->second;
+
+      typeLocAstNode->id = createIdentifier(*typeLocAstNode);
+
+      if (insertToCache(0, typeLocAstNode))
+        _astNodes.push_back(typeLocAstNode);
+    }
+
+    _locToTypeLoc.clear();
+    _typeLocBytes = 0;
+  }
+
+  /**
+   * This function returns the approximate size of the collected objects in
+   * bytes. The strings of the AST nodes (e.g. mangled names of template
+   * instantiations) are counted, since they are the bulk of the memory. Only
+   * the nodes collected since the last call are measured. The maps of the
+   * type locations and of the visited declarations are counted too.
+   */
+  std::size_t collectedBytes()
+  {
+    for (; _measuredAstNodes < _astNodes.size(); ++_measuredAstNodes)
+      _astNodeBytes += nodeBytes(*_astNodes[_measuredAstNodes]);
+
+    return _astNodeBytes
+      + _typeLocBytes + mapBytes(_locToTypeLoc)
+      + mapBytes(_clangToAstNodeId)
+      + objectBytes(_enumConstants) * _enumConstants.size()
+      + objectBytes(_enums) * _enums.size()
+      + objectBytes(_types) * _types.size()
+      + objectBytes(_typedefs) * _typedefs.size()
+      + objectBytes(_variables) * _variables.size()
+      + objectBytes(_namespaces) * _namespaces.size()
+      + objectBytes(_members) * _members.size()
+      + objectBytes(_inheritances) * _inheritances.size()
+      + objectBytes(_friends) * _friends.size()
+      + objectBytes(_functions) * _functions.size()
+      + objectBytes(_relations) * _relations.size();
+  }
+
+  /**
+   * Size of an object held by the given container, including its shared
+   * pointer and the control block of the pointer.
+   */
+  template <typename T>
+  static constexpr std::size_t objectBytes(
+    const std::vector<std::shared_ptr<T>>&)
+  {
+    return sizeof(T) + sizeof(std::shared_ptr<T>) + 2 * sizeof(long);
+  }
+
+  /**
+   * Size of an AST node with its strings, its shared pointer and the control
+   * block of the pointer.
+   */
+  static std::size_t nodeBytes(const model::CppAstNode& node_)
+  {
+    return sizeof(model::CppAstNode) + sizeof(model::CppAstNodePtr)
+      + 2 * sizeof(long)
+      + node_.astValue.capacity() + node_.mangledName.capacity();
+  }
+
+  /**
+   * Size of the elements and the buckets of a hash map, without the objects
+   * which the elements point to.
+   */
+  template <typename Map>
+  static std::size_t mapBytes(const Map& map_)
+  {
+    return map_.size() * (sizeof(typename Map::value_type) + 2 * sizeof(void*))
+      + map_.bucket_count() * sizeof(void*);
+  }
+
+  template <typename T>
+  static void release(std::vector<T>& container_)
+  {
+    std::vector<T>().swap(container_);
+  }
+
+  /**
+   * This function returns true if the given declaration is located in a
+   * header which has already been visited in another translation unit with
+   * the same transcript. Only the declarations at namespace level are
+   * skipped as a whole, but the implicit members of the skipped classes are
+   * still visited (see traverseImplicitMembers()). Templates are never
+   * skipped, because their instantiations depend on the translation unit.
+   */
+  bool isIndexedHeaderDecl(const clang::Decl* decl_) const
+  {
+    if (_headerTranscripts.empty())
+      return false;
+
+    const clang::DeclContext* context = decl_->getLexicalDeclContext();
+    if (!context || !context->getRedeclContext()->isFileContext())
+      return false;
+
+    if (llvm::isa<clang::NamespaceDecl>(decl_) ||
+        llvm::isa<clang::LinkageSpecDecl>(decl_) ||
+        hasTemplate(decl_))
+      return false;
+
+    clang::SourceLocation loc
+      = _clangSrcMgr.getExpansionLoc(decl_->getLocation());
+
+    if (loc.isInvalid())
+      return false;
+
+    clang::FileID fid = _clangSrcMgr.getFileID(loc);
+
+    if (fid == _clangSrcMgr.getMainFileID())
+      return false;
+
+    auto it = _headerTranscripts.find(fid.getHashValue());
+
+    return it != _headerTranscripts.end()
+      && _indexedHeaders.contains(it->second);
+  }
+
+  /**
+   * Sema declares the implicit special members of a class lazily, depending
+   * on their use in the translation unit. Therefore the implicit members of
+   * the classes in a skipped header are still visited, because they may
+   * differ from the ones of the translation unit which indexed the header.
+   */
+  void traverseImplicitMembers(clang::Decl* decl_)
+  {
+    clang::CXXRecordDecl* rd = llvm::dyn_cast<clang::CXXRecordDecl>(decl_);
+
+    if (!rd || !rd->isThisDeclarationADefinition())
+      return;
+
+    // The members find their class at the top of the type stack. This type is
+    // not persisted, because it has no AST node ID.
+    model::CppTypePtr type = std::make_shared<model::CppType>();
+    type->mangledNameHash = util::fnvHash(getMangledName(
+      _mngCtx, rd, getFileLoc(rd->getLocStart(), rd->getLocEnd())));
+
+    _typeStack.push(type);
+
+    for (clang::Decl* member : rd->decls())
+    {
+      // The implicit record is the injected class name.
+      if (!member->isImplicit())
+        traverseImplicitMembers(member);
+      else if (!llvm::isa<clang::CXXRecordDecl>(member))
+        TraverseDecl(member);
+    }
+
+    _typeStack.pop();
+  }
+
+  /**
+   * This function returns true if the given declaration is a template, a
+   * template specialization or a class containing such declarations.
+   */
+  static bool hasTemplate(const clang::Decl* decl_)
+  {
+    if (llvm::isa<clang::TemplateDecl>(decl_) ||
+        llvm::isa<clang::ClassTemplateSpecializationDecl>(decl_) ||
+        llvm::isa<clang::VarTemplateSpecializationDecl>(decl_))
+      return true;
+
+    if (const clang::FunctionDecl* fd
+        = llvm::dyn_cast<clang::FunctionDecl>(decl_))
+      return fd->getTemplatedKind() != clang::FunctionDecl::TK_NonTemplate;
+
+    if (const clang::CXXRecordDecl* rd
+        = llvm::dyn_cast<clang::CXXRecordDecl>(decl_))
+      for (const clang::Decl* member : rd->decls())
+        if (hasTemplate(member))
+          return true;
+
+    return false;
+  }
+
   /**
    * This function inserts a model::CppAstNodeId to a cache in a thread-safe
    * way. The cache is static so the parsers in each thread can use the same.
@@ -1363,6 +1635,10 @@ private:
     return false;
   }
 
+  // The pool has to be declared before the members holding AST nodes, so
+  // that it is destroyed after them.
+  ObjectPool _astNodePool;
+
   std::vector<model::CppAstNodePtr>      _astNodes;
   std::vector<model::CppEnumConstantPtr> _enumConstants;
   std::vector<model::CppEnumPtr>         _enums;
@@ -1395,8 +1671,29 @@ private:
   MangledNameCache& _mangledNameCache;
   std::unordered_map<const void*, model::CppAstNodeId>& _clangToAstNodeId;
 
+  IndexedHeaders& _indexedHeaders;
+  const HeaderTranscripts& _headerTranscripts;
+
   std::unordered_map<unsigned, model::CppAstNodePtr> _locToTypeLoc;
   std::unordered_map<unsigned, model::CppAstNode::AstType> _locToAstType;
+
+  /**
+   * Memory limit of the collected objects in bytes. 0 means no limit.
+   */
+  const std::size_t _memoryLimit;
+  std::size_t _measuredAstNodes;
+  std::size_t _astNodeBytes;
+
+  /**
+   * Size of the AST nodes in _locToTypeLoc.
+   */
+  std::size_t _typeLocBytes;
+
+  /**
+   * Size of the collected data which is not released by persistCollected().
+   * Only the growth of this counts against the memory limit.
+   */
+  std::size_t _retainedBytes;
 };
 
 }
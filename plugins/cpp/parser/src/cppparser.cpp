@@ -1,8 +1,11 @@
 #include <algorithm>
+#include <cctype>
+#include <chrono>
 #include <numeric>
 #include <fstream>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 
@@ -19,8 +22,20 @@
 #include <model/buildaction-odb.hxx>
 #include <model/buildsourcetarget.h>
 #include <model/buildsourcetarget-odb.hxx>
+#include <model/cppastnode.h>
+#include <model/cppastnode-odb.hxx>
+#include <model/cppedge.h>
+#include <model/cppedge-odb.hxx>
+#include <model/cppheaderinclusion.h>
+#include <model/cppheaderinclusion-odb.hxx>
+#include <model/cppparsetime.h>
+#include <model/cppparsetime-odb.hxx>
+#include <model/cpptype.h>
+#include <model/cpptype-odb.hxx>
 #include <model/file.h>
 #include <model/file-odb.hxx>
+#include <model/filecontent.h>
+#include <model/filecontent-odb.hxx>
 
 #include <util/hash.h>
 #include <util/logutil.h>
@@ -30,11 +45,180 @@
 #include <cppparser/cppparser.h>
 
 #include "clangastvisitor.h"
+#include "referencecounter.h"
 #include "relationcollector.h"
+#include "indexedheaders.h"
 #include "manglednamecache.h"
 #include "ppincludecallback.h"
 #include "ppmacrocallback.h"
+#include "pptranscriptcallback.h"
 #include "doccommentcollector.h"
+#include "preamblecache.h"
+
+namespace
+{
+
+/**
+ * This function returns the SQL statements which delete the C++ specific rows
+ * belonging to the given file before it is parsed again. The rows referring to
+ * the AST nodes of the file are selected by subqueries, so the cleanup takes
+ * a few statements per file instead of a few statements per AST node. The AST
+ * nodes themselves are deleted together with the file.
+ */
+std::vector<std::string> cleanupStatements(cc::model::FileId fileId_)
+{
+  // IDs and hashes are stored as signed 64-bit integers in the database.
+  const std::string file
+    = std::to_string(static_cast<std::int64_t>(fileId_));
+  const std::string definition = std::to_string(static_cast<int>(
+    cc::model::CppAstNode::AstType::Definition));
+
+  const std::string nodes
+    = "SELECT \"id\" FROM \"CppAstNode\""
+      " WHERE \"location_file\" = " + file;
+  const std::string definitions
+    = "SELECT \"mangledNameHash\" FROM \"CppAstNode\""
+      " WHERE \"location_file\" = " + file +
+      " AND \"astType\" = " + definition;
+
+  return {
+    // The rows of the derived entity tables are deleted by cascade.
+    "DELETE FROM \"CppEntity\" WHERE \"astNodeId\" IN (" + nodes + ")",
+    "DELETE FROM \"CppMacroExpansion\""
+      " WHERE \"astNodeId\" IN (" + nodes + ")",
+    "DELETE FROM \"CppInheritance\""
+      " WHERE \"derived\" IN (" + definitions + ")",
+    "DELETE FROM \"CppFriendship\""
+      " WHERE \"target\" IN (" + definitions + ")",
+    "DELETE FROM \"CppRelation\" WHERE \"lhs\" IN (" + definitions + ")",
+    "DELETE FROM \"BuildAction\" WHERE \"id\" IN"
+      " (SELECT \"action\" FROM \"BuildSource\" WHERE \"file\" = " + file
+      + ")",
+    "DELETE FROM \"CppEdge\" WHERE \"from\" = " + file
+  };
+}
+
+/**
+ * This function replaces the ordinary comments of the given C++ source by
+ * spaces and drops the whitespace at the end of the lines, so every token
+ * keeps its line and column. The results of two sources are equal only if
+ * their tokens are the same at the same positions. Documentation comments are
+ * kept as they are, because they are stored for the declarations. It returns
+ * false if the source contains something which is not handled (an
+ * unterminated comment or a raw string literal).
+ */
+bool blankComments(const std::string& content_, std::string& code_)
+{
+  const std::size_t size = content_.size();
+
+  code_.clear();
+  code_.reserve(size);
+
+  auto trimLine = [&code_]()
+  {
+    while (!code_.empty() && (code_.back() == ' ' || code_.back() == '\t' ||
+      code_.back() == '\r'))
+      code_.pop_back();
+  };
+
+  auto blank = [&](std::size_t begin_, std::size_t end_)
+  {
+    for (std::size_t i = begin_; i < end_; ++i)
+      if (content_[i] == '\n')
+      {
+        trimLine();
+        code_.push_back('\n');
+      }
+      else
+        code_.push_back(' ');
+  };
+
+  auto isDocComment = [&](std::size_t begin_)
+  {
+    const char marker = begin_ + 2 < size ? content_[begin_ + 2] : '\0';
+    const char after = begin_ + 3 < size ? content_[begin_ + 3] : '\0';
+
+    return marker == '!' || (marker == content_[begin_ + 1] &&
+      after != content_[begin_ + 1] && after != '/');
+  };
+
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    const char c = content_[i];
+    const char next = i + 1 < size ? content_[i + 1] : '\0';
+
+    if (c == '/' && (next == '/' || next == '*'))
+    {
+      std::size_t end;
+
+      if (next == '/')
+      {
+        // A line comment is continued by a backslash at the end of the line.
+        for (end = i; end < size && content_[end] != '\n'; )
+          end += content_[end] == '\\' && end + 1 < size ? 2 : 1;
+      }
+      else
+      {
+        end = content_.find("*/", i + 2);
+        if (end == std::string::npos)
+          return false;
+
+        end += 2;
+      }
+
+      if (isDocComment(i))
+        code_.append(content_, i, end - i);
+      else
+        blank(i, end);
+
+      i = end - 1;
+      continue;
+    }
+
+    if (c == '\n')
+    {
+      trimLine();
+      code_.push_back(c);
+      continue;
+    }
+
+    // An apostrophe after a digit is a digit separator (e.g. 1'000).
+    const bool quote = c == '"' ||
+      (c == '\'' && !(i > 0 && std::isdigit(
+        static_cast<unsigned char>(content_[i - 1]))));
+
+    code_.push_back(c);
+
+    if (!quote)
+      continue;
+
+    if (c == '"' && i > 0 && content_[i - 1] == 'R')
+      return false;
+
+    // The literal is copied as is, so comment markers inside it are kept.
+    for (++i; i < size && content_[i] != c && content_[i] != '\n'; ++i)
+    {
+      code_.push_back(content_[i]);
+
+      if (content_[i] == '\\' && i + 1 < size)
+        code_.push_back(content_[++i]);
+    }
+
+    if (i < size)
+    {
+      if (content_[i] == '\n')
+        --i;
+      else
+        code_.push_back(c);
+    }
+  }
+
+  trimLine();
+
+  return true;
+}
+
+}
 
 namespace cc
 {
@@ -47,6 +231,7 @@ public:
   static void cleanUp()
   {
     MyFrontendAction::_mangledNameCache.clear();
+    MyFrontendAction::_indexedHeaders.clear();
   }
 
   static void init(ParserContext& ctx_)
@@ -73,8 +258,14 @@ private:
     MyConsumer(
       ParserContext& ctx_,
       clang::ASTContext& context_,
-      MangledNameCache& mangledNameCache_)
-        : _mangledNameCache(mangledNameCache_), _ctx(ctx_), _context(context_)
+      MangledNameCache& mangledNameCache_,
+      IndexedHeaders& indexedHeaders_,
+      const HeaderTranscripts& headerTranscripts_)
+        : _mangledNameCache(mangledNameCache_),
+          _indexedHeaders(indexedHeaders_),
+          _headerTranscripts(headerTranscripts_),
+          _ctx(ctx_),
+          _context(context_)
     {
     }
 
@@ -82,7 +273,8 @@ private:
     {
       {
         ClangASTVisitor clangAstVisitor(
-          _ctx, _context, _mangledNameCache, _clangToAstNodeId);
+          _ctx, _context, _mangledNameCache, _clangToAstNodeId,
+          _indexedHeaders, _headerTranscripts);
         clangAstVisitor.TraverseDecl(context_.getTranslationUnitDecl());
       }
 
@@ -105,6 +297,8 @@ private:
   private:
     MangledNameCache& _mangledNameCache;
     std::unordered_map<const void*, model::CppAstNodeId> _clangToAstNodeId;
+    IndexedHeaders& _indexedHeaders;
+    const HeaderTranscripts& _headerTranscripts;
 
     ParserContext& _ctx;
     clang::ASTContext& _context;
@@ -130,6 +324,10 @@ private:
       pp.addPPCallbacks(std::make_unique<PPMacroCallback>(
         _ctx, compiler_.getASTContext(), _mangledNameCache, pp));
 
+      if (!_ctx.options.count("reindex-headers"))
+        pp.addPPCallbacks(std::make_unique<PPTranscriptCallback>(
+          pp, _headerTranscripts));
+
       return true;
     }
 
@@ -137,11 +335,15 @@ private:
       clang::CompilerInstance& compiler_, llvm::StringRef) override
     {
       return std::unique_ptr<clang::ASTConsumer>(
-        new MyConsumer(_ctx, compiler_.getASTContext(), _mangledNameCache));
+        new MyConsumer(_ctx, compiler_.getASTContext(), _mangledNameCache,
+          _indexedHeaders, _headerTranscripts));
     }
 
   private:
     static MangledNameCache _mangledNameCache;
+    static IndexedHeaders _indexedHeaders;
+
+    HeaderTranscripts _headerTranscripts;
 
     ParserContext& _ctx;
   };
@@ -150,6 +352,7 @@ private:
 };
 
 MangledNameCache VisitorActionFactory::MyFrontendAction::_mangledNameCache;
+IndexedHeaders VisitorActionFactory::MyFrontendAction::_indexedHeaders;
 
 bool CppParser::isSourceFile(const std::string& file_) const
 {
@@ -301,6 +504,19 @@ int CppParser::parseWorker(const clang::tooling::CompileCommand& command_)
     std::back_inserter(commandLine),
     [](const std::string& s){ return s.c_str(); });
 
+  //--- Use precompiled preamble if available ---//
+
+  std::string pch;
+  bool buildPch = false;
+  if (_preambleCache)
+    pch = _preambleCache->getPch(command_, buildPch);
+
+  if (!pch.empty())
+  {
+    commandLine.push_back("-include-pch");
+    commandLine.push_back(pch.c_str());
+  }
+
   int argc = commandLine.size();
 
   std::string compilationDbLoadError;
@@ -313,6 +529,10 @@ int CppParser::parseWorker(const clang::tooling::CompileCommand& command_)
   if (!compilationDb)
   {
     LOG(error) << "Failed to create compilation database from command-line. " << compilationDbLoadError;
+
+    if (buildPch)
+      _preambleCache->release(command_);
+
     return 1;
   }
 
@@ -331,6 +551,15 @@ int CppParser::parseWorker(const clang::tooling::CompileCommand& command_)
 
   addCompileCommand(command_, buildAction, error);
 
+  //--- Build precompiled preamble for the next translation units ---//
+
+  // If this translation unit failed then the preamble may be broken too, so
+  // the next translation unit of the group tries it again.
+  if (buildPch && !error)
+    _preambleCache->build(command_);
+  else if (buildPch)
+    _preambleCache->release(command_);
+
   return error;
 }
 
@@ -360,33 +589,20 @@ std::vector<std::vector<std::string>> CppParser::createCleanupOrder()
     fileNameToVertex[file.first] = boost::add_vertex(g);
   }
 
-  try
+  // The edges are taken from the inclusion graph loaded by
+  // markModifiedFiles(), so no query is needed per file.
+  for (const auto& item : fileNameToVertex)
   {
-    util::OdbTransaction{_ctx.db}([&]
-    {
-      for (const auto& item : _ctx.fileStatus)
-      {
-        auto file = _ctx.srcMgr.getFile(item.first);
-
-        auto inclusions = _ctx.db->query<model::CppHeaderInclusion>(
-          odb::query<model::CppHeaderInclusion>::included == file->id);
+    auto it = _includers.find(util::fnvHash(item.first));
+    if (it == _includers.end())
+      continue;
 
-        for (const auto& inclusion : inclusions)
-        {
-          bool inserted;
-          model::FilePtr includer = inclusion.includer.load();
-          boost::graph_traits<Graph>::edge_descriptor e;
-          boost::tie(e, inserted) = boost::add_edge(
-            fileNameToVertex.at(includer->path),
-            fileNameToVertex.at(file->path), g);
-        }
-      }
-    });
-  }
-  catch (odb::database_exception&)
-  {
-    LOG(fatal) << "[cppparser] Topological ordering failed!";
-    return std::vector<std::vector<std::string>>();
+    for (model::FileId includer : it->second)
+    {
+      auto vertexIt = fileNameToVertex.find(_includerPaths.at(includer));
+      if (vertexIt != fileNameToVertex.end())
+        boost::add_edge(vertexIt->second, item.second, g);
+    }
   }
 
   if (fileNameToVertex.empty())
@@ -424,39 +640,37 @@ std::vector<std::vector<std::string>> CppParser::createCleanupOrder()
 
 void CppParser::markModifiedFiles()
 {
-  std::vector<model::FilePtr> filePtrs(_ctx.fileStatus.size());
-
-  std::transform(_ctx.fileStatus.begin(),
-                 _ctx.fileStatus.end(),
-                 filePtrs.begin(),
-                 [this](const auto& item)
-                 {
-                   if (item.second == IncrementalStatus::MODIFIED ||
-                       item.second == IncrementalStatus::DELETED)
-                   {
-                     return _ctx.srcMgr.getFile(item.first);
-                   }
-                   else
-                   {
-                     return std::make_shared<model::File>();
-                   }
-                 });
+  markByCompileCommands();
+  loadInclusionGraph();
 
   // Detect changed files through C++ header inclusions.
-  util::OdbTransaction {_ctx.db} ([&]
-  {
-    for (const model::FilePtr file : filePtrs)
-    {
-      if(file)
-      {
-        markByInclusion(file);
-      }
-    }
-  }); // end of transaction
+  markByInclusion();
 }
 
 bool CppParser::cleanupDatabase()
 {
+  // The reference counts of the symbols of the changed files are computed
+  // again after parsing (see aggregate()).
+  _countChangedSymbols = true;
+
+  for (const model::FilePtr& file : _ctx.srcMgr.getFiles())
+    _prevFiles.insert(file->id);
+
+  try
+  {
+    ReferenceCounter(_ctx.db).collectSymbols(
+      changedFiles(), _changedSymbols);
+  }
+  catch (const odb::exception& ex)
+  {
+    LOG(warning)
+      << "[cppparser] Failed to collect the symbols of the changed files: "
+      << ex.what();
+    _countChangedSymbols = false;
+  }
+
+  keepUnchangedHeaders();
+
   // Construct the topological order of the files.
   // Each subvector is layer of leaves.
 
@@ -547,37 +761,12 @@ bool CppParser::cleanupWorker(const std::string& path_)
             // Fetch file from SourceManager by path
             model::FilePtr delFile = _ctx.srcMgr.getFile(path_);
 
-            // Query CppAstNode
-            auto defCppAstNodes = _ctx.db->query<model::CppAstNode>(
-              odb::query<model::CppAstNode>::location.file == delFile->id);
-
-            for (const model::CppAstNode& astNode : defCppAstNodes)
-            {
-              // Delete CppEntity
-              _ctx.db->erase_query<model::CppEntity>(odb::query<model::CppEntity>::astNodeId == astNode.id);
-
-              if (astNode.astType == model::CppAstNode::AstType::Definition)
-              {
-                // Delete CppInheritance
-                _ctx.db->erase_query<model::CppInheritance>(
-                  odb::query<model::CppInheritance>::derived == astNode.mangledNameHash);
-
-                // Delete CppFriendship
-                _ctx.db->erase_query<model::CppFriendship>(
-                  odb::query<model::CppFriendship>::target == astNode.mangledNameHash);
-              }
-            }
-
-            // Delete BuildAction
-            auto delSources = _ctx.db->query<model::BuildSource>(
-              odb::query<model::BuildSource>::file == delFile->id);
-            for (const model::BuildSource& source : delSources)
-            {
-              _ctx.db->erase<model::BuildAction>(source.action->id);
-            }
-
-            // Delete CppEdge (connected to File)
-            _ctx.db->erase_query<model::CppEdge>(odb::query<model::CppEdge>::from == delFile->id);
+            // The data of the unchanged headers remain valid.
+            if (_sameCodeHeaders.count(delFile->id))
+              break;
+
+            for (const std::string& sql : cleanupStatements(delFile->id))
+              _ctx.db->execute(sql);
 
             break;
           }
@@ -611,9 +800,15 @@ bool CppParser::cleanupWorker(const std::string& path_)
 
 bool CppParser::parse()
 {
+  restoreUnchangedHeaders();
   initBuildActions();
   VisitorActionFactory::init(_ctx);
 
+  if (_ctx.options.count("reuse-preamble"))
+    _preambleCache = std::make_unique<PreambleCache>(
+      _ctx.options["workspace"].as<std::string>() + '/' +
+      _ctx.options["name"].as<std::string>() + "/cpppreamble");
+
   bool success = true;
 
   for (const std::string& input
@@ -624,10 +819,65 @@ bool CppParser::parse()
 
   VisitorActionFactory::cleanUp();
   _parsedCommandHashes.clear();
+  _includers.clear();
+  _includerPaths.clear();
+
+  if (_preambleCache)
+  {
+    _preambleCache->clear();
+    _preambleCache.reset();
+  }
 
   return success;
 }
 
+bool CppParser::aggregate()
+{
+  // Merged databases may change the counts of any symbol.
+  bool incremental = _countChangedSymbols && !_ctx.options.count("merge");
+
+  try
+  {
+    ReferenceCounter counter(_ctx.db);
+
+    if (incremental)
+    {
+      counter.collectSymbols(changedFiles(), _changedSymbols);
+      counter.count(_changedSymbols);
+    }
+    else
+      counter.count();
+  }
+  catch (const odb::exception& ex)
+  {
+    LOG(error) << "[cppparser] Failed to count references: " << ex.what();
+    return false;
+  }
+
+  _countChangedSymbols = false;
+  _changedSymbols.clear();
+  _prevFiles.clear();
+
+  return true;
+}
+
+std::vector<model::FileId> CppParser::changedFiles() const
+{
+  std::vector<model::FileId> files;
+
+  for (const auto& item : _ctx.fileStatus)
+    files.push_back(util::fnvHash(item.first));
+
+  // The files which are stored by the parsing for the first time (e.g. the
+  // headers of the added translation units).
+  if (!_prevFiles.empty())
+    for (const model::FilePtr& file : _ctx.srcMgr.getFiles())
+      if (!_prevFiles.count(file->id))
+        files.push_back(file->id);
+
+  return files;
+}
+
 void CppParser::initBuildActions()
 {
   util::OdbTransaction {_ctx.db} ([&] {
@@ -636,24 +886,380 @@ void CppParser::initBuildActions()
   });
 }
 
-void CppParser::markByInclusion(model::FilePtr file_)
+void CppParser::markByCompileCommands()
 {
-  auto inclusions = _ctx.db->query<model::CppHeaderInclusion>(
-    odb::query<model::CppHeaderInclusion>::included == file_->id);
-  
-  for (auto inc : inclusions)
+  std::unordered_map<std::uint64_t, std::uint64_t> actionCommandHashes;
+  std::unordered_map<model::FileId, std::unordered_set<std::uint64_t>>
+    sourceCommandHashes;
+
+  util::OdbTransaction {_ctx.db} ([&, this] {
+    for (const model::BuildAction& ba : _ctx.db->query<model::BuildAction>())
+      actionCommandHashes[ba.id] = util::fnvHash(ba.command);
+
+    for (const model::BuildSourceFile& source
+      : _ctx.db->query<model::BuildSourceFile>())
+      sourceCommandHashes[source.file].insert(
+        actionCommandHashes[source.action]);
+  });
+
+  // Nothing has been parsed yet, so every translation unit will be parsed.
+  if (sourceCommandHashes.empty())
+    return;
+
+  for (const std::string& input
+    : _ctx.options["input"].as<std::vector<std::string>>())
   {
-    model::FilePtr loaded = inc.includer.load();
-    if(!_ctx.fileStatus.count(loaded->path))
+    if (!boost::filesystem::is_regular_file(input))
+      continue;
+
+    std::string errorMsg;
+
+    std::unique_ptr<clang::tooling::JSONCompilationDatabase> compDb
+      = clang::tooling::JSONCompilationDatabase::loadFromFile(
+          input, errorMsg,
+          clang::tooling::JSONCommandLineSyntax::Gnu);
+
+    if (!compDb)
+    {
+      LOG(warning)
+        << "[cppparser] Couldn't check compile commands of " << input
+        << ": " << errorMsg;
+      continue;
+    }
+
+    for (const clang::tooling::CompileCommand& command
+      : compDb->getAllCompileCommands())
     {
-      _ctx.fileStatus.emplace(loaded->path, IncrementalStatus::MODIFIED);
-      LOG(debug) << "[cppparser] File modified: " << loaded->path;
+      std::uint64_t hash = util::fnvHash(
+        boost::algorithm::join(command.CommandLine, " "));
+
+      for (const auto& srcTarget : extractInputOutputs(command))
+      {
+        const std::string& path = srcTarget.first;
+
+        if (_ctx.fileStatus.count(path))
+          continue;
+
+        auto it = sourceCommandHashes.find(util::fnvHash(path));
 
-      markByInclusion(loaded);
+        if (it == sourceCommandHashes.end())
+        {
+          _ctx.fileStatus.emplace(path, IncrementalStatus::ADDED);
+          LOG(debug) << "[cppparser] File added: " << path;
+        }
+        else if (!it->second.count(hash))
+        {
+          // The source file is compiled with a different command, so its
+          // previous build actions have to be cleaned up.
+          _ctx.fileStatus.emplace(path, IncrementalStatus::MODIFIED);
+          LOG(debug) << "[cppparser] Compile command modified: " << path;
+        }
+      }
     }
   }
 }
 
+void CppParser::loadInclusionGraph()
+{
+  _includers.clear();
+  _includerPaths.clear();
+
+  util::OdbTransaction {_ctx.db} ([this] {
+    for (const model::CppHeaderInclusionPath& inclusion
+      : _ctx.db->query<model::CppHeaderInclusionPath>())
+    {
+      _includers[inclusion.included].push_back(inclusion.includer);
+      _includerPaths.emplace(inclusion.includer, inclusion.includerPath);
+    }
+  });
+}
+
+void CppParser::markByInclusion()
+{
+  std::vector<model::FileId> stack;
+  std::vector<std::string> sameCodeHeaders;
+
+  for (const auto& item : _ctx.fileStatus)
+  {
+    if (item.second == IncrementalStatus::ADDED)
+      continue;
+
+    model::FileId fileId = util::fnvHash(item.first);
+
+    if (item.second == IncrementalStatus::MODIFIED &&
+        _includers.count(fileId) &&
+        hasSameCode(item.first))
+      sameCodeHeaders.push_back(item.first);
+    else
+      stack.push_back(fileId);
+  }
+
+  std::unordered_set<model::FileId> visited(stack.begin(), stack.end());
+  markIncluders(stack, visited);
+
+  // The tokens of a header whose code didn't change are at the same position
+  // as before, so its AST nodes and the data referring to them by ID or by
+  // mangled name remain valid. Such a header is not indexed again by any
+  // translation unit: its data is kept through the cleanup (see
+  // keepUnchangedHeaders()). If the header includes a changed file then its
+  // includers are marked anyway.
+  for (const std::string& path : sameCodeHeaders)
+  {
+    model::FileId fileId = util::fnvHash(path);
+
+    if (visited.count(fileId))
+      continue;
+
+    _sameCodeHeaders.insert(fileId);
+
+    LOG(debug)
+      << "[cppparser] Only comments or whitespace changed in " << path
+      << ", its includers are not parsed again";
+  }
+}
+
+void CppParser::markIncluders(
+  std::vector<model::FileId>& stack_,
+  std::unordered_set<model::FileId>& visited_)
+{
+  while (!stack_.empty())
+  {
+    auto it = _includers.find(stack_.back());
+    stack_.pop_back();
+
+    if (it == _includers.end())
+      continue;
+
+    for (model::FileId includer : it->second)
+    {
+      if (!visited_.insert(includer).second)
+        continue;
+
+      const std::string& path = _includerPaths.at(includer);
+
+      if (_ctx.fileStatus.emplace(path, IncrementalStatus::MODIFIED).second)
+        LOG(debug) << "[cppparser] File modified: " << path;
+
+      stack_.push_back(includer);
+    }
+  }
+}
+
+bool CppParser::hasSameCode(const std::string& path_)
+{
+  std::ifstream fileStream(path_);
+  if (!fileStream.is_open())
+    return false;
+
+  std::string newContent(
+    std::istreambuf_iterator<char>{fileStream},
+    std::istreambuf_iterator<char>{});
+
+  model::FilePtr file = _ctx.srcMgr.getFile(path_);
+  std::string oldContent;
+
+  util::OdbTransaction {_ctx.db} ([&] {
+    if (file && file->content)
+      oldContent = file->content.load()->content;
+  });
+
+  std::string oldCode, newCode;
+
+  return !oldContent.empty() &&
+    blankComments(oldContent, oldCode) &&
+    blankComments(newContent, newCode) &&
+    oldCode == newCode;
+}
+
+void CppParser::keepUnchangedHeaders()
+{
+  if (_sameCodeHeaders.empty())
+    return;
+
+  typedef odb::query<model::CppAstNode> AstNodeQuery;
+  typedef odb::query<model::CppMemberType> MemberTypeQuery;
+  typedef odb::query<model::CppHeaderInclusion> InclusionQuery;
+  typedef odb::query<model::CppEdge> EdgeQuery;
+  typedef odb::query<model::CppEdgeAttribute> EdgeAttributeQuery;
+
+  // The references between an unchanged header and a file which is parsed
+  // again are created again by the parsing.
+  auto isKept = [this](model::FileId fileId_, const std::string& path_)
+  {
+    return _sameCodeHeaders.count(fileId_) || !_ctx.fileStatus.count(path_);
+  };
+
+  util::OdbTransaction {_ctx.db} ([&, this] {
+    std::unordered_set<int> inclusions;
+    std::unordered_set<model::CppEdgeId> edges;
+
+    for (model::FileId header : _sameCodeHeaders)
+    {
+      model::FilePtr file = _ctx.db->find<model::File>(header);
+      if (!file)
+        continue;
+
+      _keptFiles.push_back(file);
+
+      for (const model::CppAstNode& node : _ctx.db->query<model::CppAstNode>(
+        AstNodeQuery::location.file == header))
+        _keptAstNodes.push_back(std::make_shared<model::CppAstNode>(node));
+
+      for (const model::CppMemberType& member
+        : _ctx.db->query<model::CppMemberType>(
+            MemberTypeQuery::memberAstNode->location.file == header))
+        _keptMemberTypes.push_back(
+          std::make_shared<model::CppMemberType>(member));
+
+      for (const model::CppHeaderInclusion& inclusion
+        : _ctx.db->query<model::CppHeaderInclusion>(
+            InclusionQuery::included == header ||
+            InclusionQuery::includer == header))
+      {
+        model::FilePtr other = inclusion.included.object_id() == header
+          ? inclusion.includer.load()
+          : inclusion.included.load();
+
+        if (isKept(other->id, other->path) &&
+            inclusions.insert(inclusion.id).second)
+          _keptInclusions.push_back(
+            std::make_shared<model::CppHeaderInclusion>(inclusion));
+      }
+
+      for (const model::CppEdge& edge : _ctx.db->query<model::CppEdge>(
+        EdgeQuery::to == header || EdgeQuery::from == header))
+      {
+        const model::FilePtr& other = edge.to->id == header
+          ? edge.from
+          : edge.to;
+
+        if (!isKept(other->id, other->path) || !edges.insert(edge.id).second)
+          continue;
+
+        _keptEdges.push_back(std::make_shared<model::CppEdge>(edge));
+
+        for (const model::CppEdgeAttribute& attr
+          : _ctx.db->query<model::CppEdgeAttribute>(
+              EdgeAttributeQuery::edge == edge.id))
+          _keptEdgeAttributes.push_back(
+            std::make_shared<model::CppEdgeAttribute>(attr));
+      }
+    }
+  });
+}
+
+void CppParser::restoreUnchangedHeaders()
+{
+  if (!_keptFiles.empty())
+  {
+    // The files are created again with their new content.
+    for (const model::FilePtr& kept : _keptFiles)
+    {
+      model::FilePtr file = _ctx.srcMgr.getFile(kept->path);
+      file->type = kept->type;
+      file->parseStatus = kept->parseStatus;
+    }
+
+    _ctx.srcMgr.persistFiles();
+
+    try
+    {
+      util::OdbTransaction {_ctx.db} ([this] {
+        util::persistAll(_keptAstNodes, _ctx.db);
+        util::persistAll(_keptMemberTypes, _ctx.db);
+        util::persistAll(_keptInclusions, _ctx.db);
+        util::persistAll(_keptEdges, _ctx.db);
+        util::persistAll(_keptEdgeAttributes, _ctx.db);
+      });
+    }
+    catch (const odb::exception& ex)
+    {
+      LOG(warning)
+        << "[cppparser] Failed to restore the data of the unchanged headers: "
+        << ex.what();
+    }
+  }
+
+  _sameCodeHeaders.clear();
+  _keptFiles.clear();
+  _keptAstNodes.clear();
+  _keptMemberTypes.clear();
+  _keptInclusions.clear();
+  _keptEdges.clear();
+  _keptEdgeAttributes.clear();
+}
+
+std::vector<std::uint64_t> CppParser::estimateParseCosts(
+  const std::vector<clang::tooling::CompileCommand>& commands_)
+{
+  // Rough weights for translation units without a recorded parse duration.
+  // Only the order of the costs matters, not their exact value.
+  const std::uint64_t bytesPerMs = 2048;
+  const std::uint64_t msPerInclusion = 20;
+
+  std::unordered_map<model::FileId, std::size_t> inclusionCounts;
+
+  util::OdbTransaction {_ctx.db} ([&, this] {
+    for (const model::CppParseTime& parseTime
+      : _ctx.db->query<model::CppParseTime>())
+      _prevParseTimes[parseTime.file] = parseTime.duration;
+
+    for (const model::CppHeaderInclusionCountByIncluder& inclusionCount
+      : _ctx.db->query<model::CppHeaderInclusionCountByIncluder>())
+      inclusionCounts[inclusionCount.includer] = inclusionCount.count;
+  });
+
+  std::vector<std::uint64_t> costs;
+  costs.reserve(commands_.size());
+
+  for (const clang::tooling::CompileCommand& command : commands_)
+  {
+    std::string path = boost::filesystem::absolute(
+      command.Filename, command.Directory).native();
+    model::FileId fileId = util::fnvHash(path);
+
+    auto timeIt = _prevParseTimes.find(fileId);
+    if (timeIt != _prevParseTimes.end())
+    {
+      costs.push_back(timeIt->second);
+      continue;
+    }
+
+    boost::system::error_code ec;
+    std::uintmax_t size = boost::filesystem::file_size(path, ec);
+    std::uint64_t cost = ec ? 0 : size / bytesPerMs;
+
+    auto incIt = inclusionCounts.find(fileId);
+    if (incIt != inclusionCounts.end())
+      cost += incIt->second * msPerInclusion;
+
+    costs.push_back(cost);
+  }
+
+  return costs;
+}
+
+void CppParser::persistParseTimes(
+  const std::unordered_map<model::FileId, std::uint64_t>& parseTimes_)
+{
+  util::OdbTransaction {_ctx.db} ([&, this] {
+    for (const auto& item : parseTimes_)
+    {
+      model::CppParseTime parseTime;
+      parseTime.file = item.first;
+      parseTime.duration = item.second;
+
+      if (_prevParseTimes.count(item.first))
+        _ctx.db->update(parseTime);
+      else
+        _ctx.db->persist(parseTime);
+    }
+  });
+
+  for (const auto& item : parseTimes_)
+    _prevParseTimes[item.first] = item.second;
+}
+
 bool CppParser::parseByJson(
   const std::string& jsonFile_,
   std::size_t threadNum_)
@@ -677,11 +1283,34 @@ bool CppParser::parseByJson(
     compDb->getAllCompileCommands();
   std::size_t numCompileCommands = compileCommands.size();
 
+  if (_preambleCache)
+    _preambleCache->addCommands(compileCommands);
+
+  //--- Order the commands by estimated cost, the most expensive first ---//
+
+  // If the long translation units were started last then they would keep a
+  // few threads busy at the end while the others are idle.
+  std::vector<std::uint64_t> costs = estimateParseCosts(compileCommands);
+
+  std::vector<std::size_t> order(numCompileCommands);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+    [&costs](std::size_t lhs_, std::size_t rhs_)
+    {
+      return costs[lhs_] > costs[rhs_];
+    });
+
   //--- Create a thread pool for the current commands ---//
+
+  std::mutex parseTimesMutex;
+  std::unordered_map<model::FileId, std::uint64_t> parseTimes;
+
   std::unique_ptr<
     util::JobQueueThreadPool<ParseJob>> pool =
     util::make_thread_pool<ParseJob>(
-      threadNum_, [this, &numCompileCommands](ParseJob& job_)
+      threadNum_,
+      [this, &numCompileCommands, &parseTimesMutex, &parseTimes](
+        ParseJob& job_)
       {
         const clang::tooling::CompileCommand& command = job_.command;
 
@@ -689,8 +1318,20 @@ bool CppParser::parseByJson(
           << '(' << job_.index << '/' << numCompileCommands << ')'
           << " Parsing " << command.Filename;
 
+        auto start = std::chrono::steady_clock::now();
+
         int error = this->parseWorker(command);
 
+        std::uint64_t duration
+          = std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::steady_clock::now() - start).count();
+
+        {
+          std::lock_guard<std::mutex> lock(parseTimesMutex);
+          parseTimes[util::fnvHash(boost::filesystem::absolute(
+            command.Filename, command.Directory).native())] = duration;
+        }
+
         if (error)
           LOG(warning)
             << '(' << job_.index << '/' << numCompileCommands << ')'
@@ -700,8 +1341,9 @@ bool CppParser::parseByJson(
   //--- Push all commands into the thread pool's queue ---//
   std::size_t index = 0;
 
-  for (const auto& command : compileCommands)
+  for (std::size_t i : order)
   {
+    const clang::tooling::CompileCommand& command = compileCommands[i];
     ParseJob job(command, ++index);
 
     auto hash = util::fnvHash(
@@ -722,12 +1364,16 @@ bool CppParser::parseByJson(
 
     //--- Push the job ---//
 
-    pool->enqueue(job);
+    pool->enqueue(job, costs[i]);
   }
 
   // Block execution until every job is finished.
   pool->wait();
 
+  //--- Save parse durations for the scheduling of the next run ---//
+
+  persistParseTimes(parseTimes);
+
   return true;
 }
 
@@ -745,7 +1391,25 @@ extern "C"
     description.add_options()
       ("skip-doccomment",
        "If this flag is given the parser will skip parsing the documentation "
-       "comments.");
+       "comments.")
+      ("reuse-preamble",
+       "If this flag is given the parser builds a precompiled header for the "
+       "translation units sharing the same compiler flags and the same "
+       "#include directives at the beginning of their source file. The "
+       "headers are parsed only once for the group. Preprocessor events (e.g. "
+       "macro expansions) inside these headers are recorded only by the first "
+       "translation unit of the group.")
+      ("reindex-headers",
+       "By default the declarations of a header are visited only once if the "
+       "header is included by several translation units with the same "
+       "preprocessor context. If this flag is given then the declarations of "
+       "the headers are visited in every translation unit.")
+      ("visitor-memory-limit",
+       boost::program_options::value<std::size_t>()->default_value(0),
+       "Approximate memory limit in megabytes for the AST information "
+       "collected by a parser thread. If the collected objects exceed this "
+       "limit then they are written to the database during the traversal of "
+       "the translation unit, instead of at its end. 0 means no limit.");
     return description;
   }
 
@@ -0,0 +1,27 @@
+#include "indexedheaders.h"
+
+namespace cc
+{
+namespace parser
+{
+
+bool IndexedHeaders::contains(std::uint64_t transcript_) const
+{
+  std::lock_guard<std::mutex> guard(_mutex);
+  return _transcripts.count(transcript_);
+}
+
+void IndexedHeaders::insert(std::uint64_t transcript_)
+{
+  std::lock_guard<std::mutex> guard(_mutex);
+  _transcripts.insert(transcript_);
+}
+
+void IndexedHeaders::clear()
+{
+  std::lock_guard<std::mutex> guard(_mutex);
+  _transcripts.clear();
+}
+
+} // parser
+} // cc
@@ -0,0 +1,49 @@
+#ifndef CC_PARSER_INDEXEDHEADERS_H
+#define CC_PARSER_INDEXEDHEADERS_H
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_set>
+
+namespace cc
+{
+namespace parser
+{
+
+/**
+ * Thread safe registry of header files whose declarations have already been
+ * visited by ClangASTVisitor in a translation unit.
+ *
+ * A header is identified by its transcript hash (see PPTranscriptCallback),
+ * which covers the content of the header and the definitions of every macro
+ * the header refers to. Two inclusions with the same transcript produce the
+ * same declarations, so the declarations of the second one can be skipped.
+ */
+class IndexedHeaders
+{
+public:
+  /**
+   * This function returns true if a header with the given transcript has
+   * already been indexed.
+   */
+  bool contains(std::uint64_t transcript_) const;
+
+  /**
+   * This function marks a header with the given transcript as indexed.
+   */
+  void insert(std::uint64_t transcript_);
+
+  /**
+   * Removes all elements from the registry.
+   */
+  void clear();
+
+private:
+  std::unordered_set<std::uint64_t> _transcripts;
+  mutable std::mutex _mutex;
+};
+
+} // parser
+} // cc
+
+#endif // CC_PARSER_INDEXEDHEADERS_H
@@ -5,23 +5,45 @@ namespace cc
 namespace parser
 {
 
+constexpr std::size_t MangledNameCache::SHARD_COUNT;
+
 bool MangledNameCache::insert(const model::CppAstNode& node_)
 {
-  std::lock_guard<std::mutex> guard(_cacheMutex);
-  return _mangledNameCache.insert(
+  Shard& shard = getShard(node_.id);
+
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  return shard.cache.insert(
     std::make_pair(node_.id, node_.mangledNameHash)).second;
 }
 
 std::uint64_t MangledNameCache::at(const model::CppAstNodeId& id_) const
 {
-  std::lock_guard<std::mutex> guard(_cacheMutex);
-  return _mangledNameCache.at(id_);
+  const Shard& shard = getShard(id_);
+
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  return shard.cache.at(id_);
 }
 
 void MangledNameCache::clear()
 {
-  _mangledNameCache.clear();
+  for (Shard& shard : _shards)
+  {
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    shard.cache.clear();
+  }
 }
 
+MangledNameCache::Shard& MangledNameCache::getShard(
+  const model::CppAstNodeId& id_)
+{
+  return _shards[(id_ >> 56) & (SHARD_COUNT - 1)];
 }
+
+const MangledNameCache::Shard& MangledNameCache::getShard(
+  const model::CppAstNodeId& id_) const
+{
+  return _shards[(id_ >> 56) & (SHARD_COUNT - 1)];
 }
+
+} // parser
+} // cc
@@ -1,6 +1,7 @@
 #ifndef CC_PARSER_MANGLEDNAMECACHE_H
 #define CC_PARSER_MANGLEDNAMECACHE_H
 
+#include <array>
 #include <unordered_map>
 #include <mutex>
 
@@ -13,6 +14,11 @@ namespace parser
 
 /**
  * Thread safe mangled name cache.
+ *
+ * The cache is split into shards which are guarded by their own mutex, so
+ * parser threads inserting different AST nodes rarely wait for each other.
+ * The shard of an entry is selected by the bits of its AST node ID. Since the
+ * IDs are FNV hashes, the entries are distributed evenly among the shards.
  */
 class MangledNameCache
 {
@@ -38,8 +44,22 @@ public:
   void clear();
 
 private:
-  std::unordered_map<model::CppAstNodeId, std::uint64_t> _mangledNameCache;
-  mutable std::mutex _cacheMutex;
+  /**
+   * Number of shards. It has to be a power of two, because the shard index is
+   * computed by masking the ID.
+   */
+  static constexpr std::size_t SHARD_COUNT = 256;
+
+  struct Shard
+  {
+    std::unordered_map<model::CppAstNodeId, std::uint64_t> cache;
+    mutable std::mutex mutex;
+  };
+
+  Shard& getShard(const model::CppAstNodeId& id_);
+  const Shard& getShard(const model::CppAstNodeId& id_) const;
+
+  std::array<Shard, SHARD_COUNT> _shards;
 };
 
 } // parser
@@ -0,0 +1,69 @@
+#include <algorithm>
+
+#include "objectpool.h"
+
+namespace cc
+{
+namespace parser
+{
+
+ObjectPool::ObjectPool(std::size_t blocksPerChunk_)
+  : _blocksPerChunk(blocksPerChunk_),
+    _blockSize(0),
+    _requestSize(0),
+    _freeList(nullptr)
+{
+}
+
+void* ObjectPool::allocate(std::size_t size_)
+{
+  if (!_requestSize)
+  {
+    const std::size_t align = alignof(std::max_align_t);
+
+    _requestSize = size_;
+    _blockSize = std::max(size_, sizeof(FreeBlock));
+    _blockSize = (_blockSize + align - 1) / align * align;
+  }
+
+  if (size_ != _requestSize)
+    return ::operator new(size_);
+
+  if (!_freeList)
+    addChunk();
+
+  FreeBlock* block = _freeList;
+  _freeList = block->next;
+
+  return block;
+}
+
+void ObjectPool::deallocate(void* ptr_, std::size_t size_)
+{
+  if (size_ != _requestSize)
+  {
+    ::operator delete(ptr_);
+    return;
+  }
+
+  FreeBlock* block = static_cast<FreeBlock*>(ptr_);
+  block->next = _freeList;
+  _freeList = block;
+}
+
+void ObjectPool::addChunk()
+{
+  // The memory returned by new[] is aligned for any fundamental type.
+  char* chunk = new char[_blockSize * _blocksPerChunk];
+  _chunks.emplace_back(chunk);
+
+  for (std::size_t i = 0; i < _blocksPerChunk; ++i)
+  {
+    FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + i * _blockSize);
+    block->next = _freeList;
+    _freeList = block;
+  }
+}
+
+} // parser
+} // cc
@@ -0,0 +1,105 @@
+#ifndef CC_PARSER_OBJECTPOOL_H
+#define CC_PARSER_OBJECTPOOL_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace cc
+{
+namespace parser
+{
+
+/**
+ * Memory pool for the short-lived objects of a single translation unit.
+ *
+ * The pool hands out blocks of the same size which are carved from large
+ * chunks, and the released blocks are reused by later allocations. This way
+ * the objects created during the traversal of an AST need only a few calls
+ * to malloc, and the memory is not fragmented by them. The size of the blocks
+ * is determined by the first allocation; requests of other sizes are served
+ * by the global operator new.
+ *
+ * The pool is not thread safe, it has to be owned by a single parser thread.
+ * The chunks are freed when the pool is destroyed, so the pool must outlive
+ * the objects allocated from it.
+ */
+class ObjectPool
+{
+public:
+  ObjectPool(std::size_t blocksPerChunk_ = 4096);
+  ObjectPool(const ObjectPool&) = delete;
+  ObjectPool& operator=(const ObjectPool&) = delete;
+
+  void* allocate(std::size_t size_);
+  void deallocate(void* ptr_, std::size_t size_);
+
+private:
+  struct FreeBlock
+  {
+    FreeBlock* next;
+  };
+
+  void addChunk();
+
+  const std::size_t _blocksPerChunk;
+  std::size_t _blockSize;
+  std::size_t _requestSize;
+  FreeBlock* _freeList;
+  std::vector<std::unique_ptr<char[]>> _chunks;
+};
+
+/**
+ * Standard allocator which allocates single objects from an ObjectPool. It
+ * can be used with std::allocate_shared() so that the object and the control
+ * block of the shared pointer are stored in one pool block.
+ */
+template <typename T>
+class PoolAllocator
+{
+public:
+  typedef T value_type;
+
+  PoolAllocator(ObjectPool& pool_) : _pool(&pool_)
+  {
+  }
+
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U>& other_) : _pool(other_._pool)
+  {
+  }
+
+  T* allocate(std::size_t n_)
+  {
+    return static_cast<T*>(_pool->allocate(n_ * sizeof(T)));
+  }
+
+  void deallocate(T* ptr_, std::size_t n_)
+  {
+    _pool->deallocate(ptr_, n_ * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(const PoolAllocator<U>& other_) const
+  {
+    return _pool == other_._pool;
+  }
+
+  template <typename U>
+  bool operator!=(const PoolAllocator<U>& other_) const
+  {
+    return _pool != other_._pool;
+  }
+
+private:
+  template <typename U>
+  friend class PoolAllocator;
+
+  ObjectPool* _pool;
+};
+
+} // parser
+} // cc
+
+#endif // CC_PARSER_OBJECTPOOL_H
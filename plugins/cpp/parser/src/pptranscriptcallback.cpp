@@ -0,0 +1,147 @@
+#include <clang/Basic/FileManager.h>
+#include <clang/Basic/SourceManager.h>
+#include <clang/Lex/MacroInfo.h>
+
+#include <util/hash.h>
+
+#include "pptranscriptcallback.h"
+
+namespace cc
+{
+namespace parser
+{
+
+PPTranscriptCallback::PPTranscriptCallback(
+  clang::Preprocessor& pp_,
+  HeaderTranscripts& transcripts_) :
+    _pp(pp_),
+    _clangSrcMgr(pp_.getSourceManager()),
+    _transcripts(transcripts_)
+{
+}
+
+void PPTranscriptCallback::FileChanged(
+  clang::SourceLocation loc_,
+  FileChangeReason reason_,
+  clang::SrcMgr::CharacteristicKind,
+  clang::FileID prevFid_)
+{
+  if (reason_ == EnterFile)
+  {
+    clang::FileID fid = _clangSrcMgr.getFileID(loc_);
+    std::uint64_t hash = 0;
+
+    if (const clang::FileEntry* entry = _clangSrcMgr.getFileEntryForID(fid))
+      hash = combine(hash,
+        std::string(entry->getName()) + ':' +
+        std::to_string(entry->getSize()) + ':' +
+        std::to_string(entry->getModificationTime()));
+
+    _stack.push_back(Frame{fid, hash});
+  }
+  else if (reason_ == ExitFile && !_stack.empty())
+  {
+    const Frame& frame = _stack.back();
+
+    if (frame.fid == prevFid_ && frame.hash)
+      _transcripts[frame.fid.getHashValue()] = frame.hash;
+
+    _stack.pop_back();
+  }
+}
+
+void PPTranscriptCallback::MacroExpands(
+  const clang::Token& macroNameTok_,
+  const clang::MacroDefinition& md_,
+  clang::SourceRange,
+  const clang::MacroArgs*)
+{
+  addMacroReference(macroNameTok_, md_);
+}
+
+void PPTranscriptCallback::Defined(
+  const clang::Token& macroNameTok_,
+  const clang::MacroDefinition& md_,
+  clang::SourceRange)
+{
+  addMacroReference(macroNameTok_, md_);
+}
+
+void PPTranscriptCallback::Ifdef(
+  clang::SourceLocation,
+  const clang::Token& macroNameTok_,
+  const clang::MacroDefinition& md_)
+{
+  addMacroReference(macroNameTok_, md_);
+}
+
+void PPTranscriptCallback::Ifndef(
+  clang::SourceLocation,
+  const clang::Token& macroNameTok_,
+  const clang::MacroDefinition& md_)
+{
+  addMacroReference(macroNameTok_, md_);
+}
+
+void PPTranscriptCallback::addMacroReference(
+  const clang::Token& macroNameTok_,
+  const clang::MacroDefinition& md_)
+{
+  if (_stack.empty())
+    return;
+
+  const clang::IdentifierInfo* ii = macroNameTok_.getIdentifierInfo();
+  if (!ii)
+    return;
+
+  const clang::MacroInfo* mi = md_.getMacroInfo();
+
+  Frame& frame = _stack.back();
+  frame.hash = combine(frame.hash,
+    ii->getName().str() + '=' + (mi ? getDefinitionId(mi) : "<undef>"));
+}
+
+const std::string& PPTranscriptCallback::getDefinitionId(
+  const clang::MacroInfo* mi_)
+{
+  auto it = _definitionIds.find(mi_);
+  if (it != _definitionIds.end())
+    return it->second;
+
+  std::string& id = _definitionIds[mi_];
+
+  clang::PresumedLoc presLoc
+    = _clangSrcMgr.getPresumedLoc(mi_->getDefinitionLoc());
+
+  if (presLoc.isValid() &&
+      _clangSrcMgr.getFileEntryForID(
+        _clangSrcMgr.getFileID(mi_->getDefinitionLoc())))
+  {
+    id = std::string(presLoc.getFilename()) + ':' +
+      std::to_string(presLoc.getLine()) + ':' +
+      std::to_string(presLoc.getColumn());
+  }
+  else
+  {
+    // Built-in and command line macros have no file location, so they are
+    // identified by their replacement list.
+    if (mi_->isFunctionLike())
+      id.append("(").append(std::to_string(mi_->getNumParams())).append(")");
+
+    for (const clang::Token& token : mi_->tokens())
+      id.append(_pp.getSpelling(token)).append(" ");
+  }
+
+  return id;
+}
+
+std::uint64_t PPTranscriptCallback::combine(
+  std::uint64_t hash_,
+  const std::string& data_)
+{
+  return hash_ ^ (util::fnvHash(data_)
+    + 0x9e3779b97f4a7c15ULL + (hash_ << 6) + (hash_ >> 2));
+}
+
+} // parser
+} // cc
@@ -0,0 +1,100 @@
+#ifndef CC_PARSER_PPTRANSCRIPTCALLBACK_H
+#define CC_PARSER_PPTRANSCRIPTCALLBACK_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <clang/Lex/PPCallbacks.h>
+#include <clang/Lex/Preprocessor.h>
+
+namespace cc
+{
+namespace parser
+{
+
+/**
+ * Transcript hashes of the files of a translation unit by the hash value of
+ * their clang::FileID.
+ */
+typedef std::unordered_map<unsigned, std::uint64_t> HeaderTranscripts;
+
+/**
+ * This class computes a transcript hash for every file entered by the
+ * preprocessor. The transcript consists of the file's path, size and
+ * modification time, and the identity of the definition of every macro which
+ * is referenced while lexing the file (expanded, tested by #ifdef, #ifndef or
+ * defined()). If two inclusions of a header have the same transcript then the
+ * preprocessor produced the same tokens for them.
+ */
+class PPTranscriptCallback : public clang::PPCallbacks
+{
+public:
+  PPTranscriptCallback(
+    clang::Preprocessor& pp_,
+    HeaderTranscripts& transcripts_);
+
+  virtual void FileChanged(
+    clang::SourceLocation loc_,
+    FileChangeReason reason_,
+    clang::SrcMgr::CharacteristicKind fileType_,
+    clang::FileID prevFid_) override;
+
+  virtual void MacroExpands(
+    const clang::Token& macroNameTok_,
+    const clang::MacroDefinition& md_,
+    clang::SourceRange range_,
+    const clang::MacroArgs* args_) override;
+
+  virtual void Defined(
+    const clang::Token& macroNameTok_,
+    const clang::MacroDefinition& md_,
+    clang::SourceRange range_) override;
+
+  virtual void Ifdef(
+    clang::SourceLocation loc_,
+    const clang::Token& macroNameTok_,
+    const clang::MacroDefinition& md_) override;
+
+  virtual void Ifndef(
+    clang::SourceLocation loc_,
+    const clang::Token& macroNameTok_,
+    const clang::MacroDefinition& md_) override;
+
+private:
+  struct Frame
+  {
+    clang::FileID fid;
+    std::uint64_t hash;
+  };
+
+  /**
+   * This function adds a macro reference to the transcript of the file which
+   * is currently being lexed.
+   */
+  void addMacroReference(
+    const clang::Token& macroNameTok_,
+    const clang::MacroDefinition& md_);
+
+  /**
+   * This function returns a string which identifies the macro definition
+   * independently from the translation unit: the location of the definition
+   * if it is in a file, otherwise the replacement tokens.
+   */
+  const std::string& getDefinitionId(const clang::MacroInfo* mi_);
+
+  static std::uint64_t combine(std::uint64_t hash_, const std::string& data_);
+
+  clang::Preprocessor& _pp;
+  clang::SourceManager& _clangSrcMgr;
+  HeaderTranscripts& _transcripts;
+
+  std::vector<Frame> _stack;
+  std::unordered_map<const clang::MacroInfo*, std::string> _definitionIds;
+};
+
+} // parser
+} // cc
+
+#endif // CC_PARSER_PPTRANSCRIPTCALLBACK_H
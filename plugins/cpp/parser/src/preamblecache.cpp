@@ -0,0 +1,315 @@
+#include <fstream>
+
+#include <boost/algorithm/string/join.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/filesystem.hpp>
+
+#include <clang/Frontend/FrontendActions.h>
+#include <clang/Tooling/Tooling.h>
+
+#include <util/hash.h>
+#include <util/logutil.h>
+
+#include "preamblecache.h"
+
+namespace fs = boost::filesystem;
+
+namespace
+{
+
+/**
+ * This function returns the hash of the whole command line which identifies
+ * a compile command.
+ */
+std::uint64_t commandHash(const clang::tooling::CompileCommand& command_)
+{
+  return cc::util::fnvHash(boost::algorithm::join(command_.CommandLine, " "));
+}
+
+}
+
+namespace cc
+{
+namespace parser
+{
+
+constexpr std::size_t PreambleCache::MIN_GROUP_SIZE;
+
+PreambleCache::PreambleCache(const std::string& pchDir_) : _pchDir(pchDir_)
+{
+  boost::system::error_code ec;
+  fs::create_directories(_pchDir, ec);
+
+  if (ec)
+    LOG(warning)
+      << "Failed to create directory for precompiled headers: " << _pchDir;
+}
+
+void PreambleCache::addCommands(
+  const std::vector<clang::tooling::CompileCommand>& commands_)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  for (const clang::tooling::CompileCommand& command : commands_)
+  {
+    std::string preamble;
+    std::uint64_t key = computeKey(command, preamble);
+
+    _keys[commandHash(command)] = key;
+
+    if (!key)
+      continue;
+
+    Group& group = _groups[key];
+    ++group.size;
+    group.preamble = std::move(preamble);
+  }
+}
+
+std::string PreambleCache::getPch(
+  const clang::tooling::CompileCommand& command_,
+  bool& builder_)
+{
+  builder_ = false;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  auto keyIt = _keys.find(commandHash(command_));
+  if (keyIt == _keys.end() || !keyIt->second)
+    return std::string();
+
+  Group& group = _groups[keyIt->second];
+
+  if (group.size < MIN_GROUP_SIZE)
+    return std::string();
+
+  switch (group.state)
+  {
+    case State::Ready:
+      return group.pchPath;
+
+    case State::None:
+      // The caller parses this translation unit without PCH, and builds the
+      // PCH of the group afterwards.
+      group.state = State::Building;
+      builder_ = true;
+      group.pchPath = _pchDir + '/' + std::to_string(keyIt->second) + ".pch";
+      return std::string();
+
+    case State::Building:
+    case State::Failed:
+      return std::string();
+  }
+
+  return std::string();
+}
+
+void PreambleCache::build(const clang::tooling::CompileCommand& command_)
+{
+  std::string preamble;
+  std::string pchPath;
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto keyIt = _keys.find(commandHash(command_));
+    if (keyIt == _keys.end() || !keyIt->second)
+      return;
+
+    Group& group = _groups[keyIt->second];
+
+    // Only the translation unit which was chosen by getPch() builds the PCH,
+    // and it can do it only once.
+    if (group.state != State::Building || group.preamble.empty())
+      return;
+
+    preamble = group.preamble;
+    pchPath = group.pchPath;
+    group.preamble.clear();
+  }
+
+  //--- Write the preamble to a header file ---//
+
+  std::string headerPath = fs::path(pchPath).replace_extension(".h").native();
+
+  {
+    std::ofstream header(headerPath);
+    header << preamble;
+  }
+
+  //--- Assemble compiler command line ---//
+
+  bool isC = fs::extension(command_.Filename) == ".c";
+  std::string sourceDir = fs::absolute(
+    command_.Filename, command_.Directory).parent_path().native();
+
+  std::vector<std::string> args = getFlags(command_);
+  args.insert(args.end(), {
+    // Quoted includes of the preamble are relative to the source file.
+    "-iquote", sourceDir,
+    "-x", isC ? "c-header" : "c++-header",
+    "-o", pchPath});
+
+  std::vector<const char*> commandLine;
+  commandLine.reserve(args.size() + 1);
+  commandLine.push_back("--");
+  for (const std::string& arg : args)
+    commandLine.push_back(arg.c_str());
+
+  int argc = commandLine.size();
+
+  std::string compilationDbLoadError;
+  std::unique_ptr<clang::tooling::FixedCompilationDatabase> compilationDb(
+    clang::tooling::FixedCompilationDatabase::loadFromCommandLine(
+      argc,
+      commandLine.data(),
+      compilationDbLoadError));
+
+  //--- Build the PCH ---//
+
+  int error = 1;
+
+  if (compilationDb)
+  {
+    clang::tooling::ClangTool tool(*compilationDb, headerPath);
+
+    // The default adjusters would turn the command into a syntax-only run
+    // without output file.
+    tool.clearArgumentsAdjusters();
+
+    error = tool.run(clang::tooling::newFrontendActionFactory<
+      clang::GeneratePCHAction>().get());
+  }
+  else
+    LOG(warning)
+      << "Failed to create compilation database for precompiled header. "
+      << compilationDbLoadError;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  Group& group = _groups[_keys[commandHash(command_)]];
+  group.state = error ? State::Failed : State::Ready;
+
+  if (error)
+    LOG(warning)
+      << "Building precompiled header for " << command_.Filename
+      << " has been failed, its group is parsed without it.";
+  else
+    LOG(debug)
+      << "Precompiled header " << pchPath << " has been built for "
+      << group.size << " translation units.";
+}
+
+void PreambleCache::release(const clang::tooling::CompileCommand& command_)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  auto keyIt = _keys.find(commandHash(command_));
+  if (keyIt == _keys.end() || !keyIt->second)
+    return;
+
+  Group& group = _groups[keyIt->second];
+
+  // The preamble is cleared when the building has already been started.
+  if (group.state == State::Building && !group.preamble.empty())
+    group.state = State::None;
+}
+
+void PreambleCache::clear()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  boost::system::error_code ec;
+  fs::remove_all(_pchDir, ec);
+
+  _groups.clear();
+  _keys.clear();
+}
+
+std::string PreambleCache::readPreamble(const std::string& path_)
+{
+  std::ifstream source(path_);
+  std::string preamble;
+  std::string line;
+  bool inComment = false;
+
+  while (std::getline(source, line))
+  {
+    boost::algorithm::trim(line);
+
+    if (inComment)
+    {
+      inComment = line.find("*/") == std::string::npos;
+      continue;
+    }
+
+    if (line.empty() || boost::algorithm::starts_with(line, "//"))
+      continue;
+
+    if (boost::algorithm::starts_with(line, "/*"))
+    {
+      inComment = line.find("*/", 2) == std::string::npos;
+      continue;
+    }
+
+    // Any other directive (e.g. #define) may change the meaning of the
+    // following headers, so the preamble ends here.
+    if (!boost::algorithm::starts_with(line, "#include"))
+      break;
+
+    preamble.append(line).append("\n");
+  }
+
+  return preamble;
+}
+
+std::vector<std::string> PreambleCache::getFlags(
+  const clang::tooling::CompileCommand& command_)
+{
+  std::vector<std::string> flags;
+
+  // The first argument is the compiler.
+  for (std::size_t i = 1; i < command_.CommandLine.size(); ++i)
+  {
+    const std::string& arg = command_.CommandLine[i];
+
+    if (arg == "-o" || arg == "-x" ||
+        arg == "-MF" || arg == "-MT" || arg == "-MQ")
+      ++i;
+    else if (arg == "-c" || arg == command_.Filename ||
+        arg == "-MD" || arg == "-MMD" || arg == "-MP")
+      continue;
+    else
+      flags.push_back(arg);
+  }
+
+  return flags;
+}
+
+std::uint64_t PreambleCache::computeKey(
+  const clang::tooling::CompileCommand& command_,
+  std::string& preamble_)
+{
+  std::string path
+    = fs::absolute(command_.Filename, command_.Directory).native();
+
+  preamble_ = readPreamble(path);
+
+  if (preamble_.empty())
+    return 0;
+
+  std::string key = command_.Directory;
+  key.append("\n").append(boost::algorithm::join(getFlags(command_), " "));
+  key.append("\n").append(preamble_);
+
+  // Quoted includes are resolved relative to the source file, so the same
+  // preamble means the same headers only in the same directory.
+  if (preamble_.find('"') != std::string::npos)
+    key.append("\n").append(fs::path(path).parent_path().native());
+
+  return util::fnvHash(key);
+}
+
+} // parser
+} // cc
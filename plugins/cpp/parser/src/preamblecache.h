@@ -0,0 +1,141 @@
+#ifndef CC_PARSER_PREAMBLECACHE_H
+#define CC_PARSER_PREAMBLECACHE_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <clang/Tooling/CompilationDatabase.h>
+
+namespace cc
+{
+namespace parser
+{
+
+/**
+ * Thread safe cache of precompiled headers (PCH).
+ *
+ * Translation units are grouped by their compiler flags, working directory and
+ * the #include directives at the beginning of their main source file (the
+ * preamble). For every group which is large enough, the preamble is compiled to
+ * a PCH once, and the rest of the group loads it with -include-pch instead of
+ * parsing the same headers again.
+ *
+ * The first translation unit of a group is always parsed without PCH, so the
+ * header inclusions and macro expansions inside the preamble's headers are
+ * recorded by it. Translation units using the PCH see the declarations of the
+ * preamble's headers, but not the preprocessor events inside them.
+ */
+class PreambleCache
+{
+public:
+  /**
+   * @param pchDir_ Directory where the generated preamble headers and PCH
+   * files are placed.
+   */
+  PreambleCache(const std::string& pchDir_);
+
+  /**
+   * This function registers the compile commands which are going to be
+   * parsed, so that the size of the groups is known in advance. PCH is built
+   * only for groups having at least MIN_GROUP_SIZE translation units.
+   */
+  void addCommands(
+    const std::vector<clang::tooling::CompileCommand>& commands_);
+
+  /**
+   * This function returns the path of the PCH file which the given
+   * translation unit can use. If no PCH is available (yet) then an empty
+   * string returns. If the caller is chosen to build the PCH of the group
+   * then builder_ is set to true, and the caller is expected to call build()
+   * after parsing the translation unit successfully, or release() otherwise.
+   */
+  std::string getPch(
+    const clang::tooling::CompileCommand& command_,
+    bool& builder_);
+
+  /**
+   * This function builds the PCH of the group of the given command if the
+   * caller was chosen to do so by a previous getPch() call. Otherwise the
+   * function does nothing.
+   */
+  void build(const clang::tooling::CompileCommand& command_);
+
+  /**
+   * This function gives back the building of the PCH of the group of the
+   * given command when the translation unit chosen by getPch() couldn't be
+   * parsed. The next translation unit of the group is chosen instead.
+   */
+  void release(const clang::tooling::CompileCommand& command_);
+
+  /**
+   * This function removes the generated files.
+   */
+  void clear();
+
+private:
+  enum class State
+  {
+    None,
+    Building,
+    Ready,
+    Failed
+  };
+
+  struct Group
+  {
+    std::size_t size = 0;
+    State state = State::None;
+    std::string preamble;
+    std::string pchPath;
+  };
+
+  /**
+   * Minimal number of translation units in a group for which it is worth to
+   * build a PCH.
+   */
+  static constexpr std::size_t MIN_GROUP_SIZE = 3;
+
+  /**
+   * This function returns the #include directives at the beginning of the
+   * given source file, skipping empty lines and comments.
+   */
+  static std::string readPreamble(const std::string& path_);
+
+  /**
+   * This function returns the arguments of the compile command which
+   * influence the parsing of the preamble, i.e. without the compiler name, the
+   * source files and the output options.
+   */
+  static std::vector<std::string> getFlags(
+    const clang::tooling::CompileCommand& command_);
+
+  /**
+   * This function returns the key of the group which the translation unit of
+   * the given command belongs to, or 0 if it has no preamble.
+   */
+  static std::uint64_t computeKey(
+    const clang::tooling::CompileCommand& command_,
+    std::string& preamble_);
+
+  std::string _pchDir;
+
+  /**
+   * Groups of translation units by their key.
+   */
+  std::unordered_map<std::uint64_t, Group> _groups;
+
+  /**
+   * Group keys by the hash of the compile commands.
+   */
+  std::unordered_map<std::uint64_t, std::uint64_t> _keys;
+
+  std::mutex _mutex;
+};
+
+} // parser
+} // cc
+
+#endif // CC_PARSER_PREAMBLECACHE_H
@@ -0,0 +1,393 @@
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <model/cppastnode.h>
+#include <model/cppastnode-odb.hxx>
+#include <model/cppreferencecount.h>
+#include <model/cppreferencecount-odb.hxx>
+#include <model/cpprelation.h>
+#include <model/cpprelation-odb.hxx>
+
+#include <util/logutil.h>
+#include <util/odbtransaction.h>
+
+#include "referencecounter.h"
+
+namespace
+{
+
+typedef std::unordered_map<std::uint64_t, std::vector<std::uint64_t>> Graph;
+typedef std::unordered_map<std::uint64_t, cc::model::CppReferenceCountPtr>
+  Counts;
+
+/**
+ * The number of values in an SQL IN list.
+ */
+const std::size_t chunkSize = 1000;
+
+/**
+ * This function returns the SQL literal of an enum constant of CppAstNode.
+ */
+template <typename Enum>
+std::string sqlValue(Enum value_)
+{
+  return std::to_string(static_cast<int>(value_));
+}
+
+/**
+ * This function calls func_ with the chunks of the given IDs and the SQL IN
+ * list of the chunk. The IDs are stored as signed 64-bit integers in the
+ * database.
+ */
+template <typename Func>
+void forEachChunk(const std::vector<std::uint64_t>& ids_, Func func_)
+{
+  for (std::size_t begin = 0; begin < ids_.size(); begin += chunkSize)
+  {
+    std::size_t end = std::min(begin + chunkSize, ids_.size());
+    std::string list;
+
+    for (std::size_t i = begin; i < end; ++i)
+      list += (list.empty() ? "(" : ", ")
+        + std::to_string(static_cast<std::int64_t>(ids_[i]));
+
+    func_(ids_.begin() + begin, ids_.begin() + end, list + ')');
+  }
+}
+
+/**
+ * This function returns the number of nodes reachable from the given node in
+ * the graph. The node itself is counted only if it is on a cycle. This matches
+ * the result of CppServiceHandler::transitiveClosureOfRel().
+ */
+std::size_t closureSize(const Graph& graph_, std::uint64_t node_)
+{
+  std::unordered_set<std::uint64_t> visited;
+  std::vector<std::uint64_t> stack{node_};
+
+  while (!stack.empty())
+  {
+    std::uint64_t current = stack.back();
+    stack.pop_back();
+
+    auto it = graph_.find(current);
+    if (it == graph_.end())
+      continue;
+
+    for (std::uint64_t next : it->second)
+      if (visited.insert(next).second)
+        stack.push_back(next);
+  }
+
+  return visited.size();
+}
+
+cc::model::CppReferenceCountPtr& getCount(
+  Counts& counts_,
+  std::uint64_t mangledNameHash_)
+{
+  cc::model::CppReferenceCountPtr& count = counts_[mangledNameHash_];
+
+  if (!count)
+  {
+    count = std::make_shared<cc::model::CppReferenceCount>();
+    count->mangledNameHash = mangledNameHash_;
+  }
+
+  return count;
+}
+
+/**
+ * This function counts the AST nodes and the callers of the symbols. The
+ * symbols can be restricted by an SQL condition on the mangledNameHash column,
+ * which is appended to the queries.
+ */
+void countAstNodes(
+  odb::database& db_,
+  const std::string& condition_,
+  Counts& counts_)
+{
+  typedef cc::model::CppAstNode::AstType AstType;
+  typedef cc::model::CppAstNode::SymbolType SymbolType;
+
+  // Positions are stored as signed 64-bit integers in the database.
+  const std::string npos = std::to_string(
+    static_cast<std::int64_t>(cc::model::Position::npos));
+
+  auto countIf = [](const std::string& cond_) {
+    return "SUM(CASE WHEN " + cond_ + " THEN 1 ELSE 0 END)";
+  };
+
+  // The conditions are the same as the ones used by
+  // CppServiceHandler::getReferenceCount() for the live counting.
+  const std::string byTypeSql
+    = "SELECT \"mangledNameHash\", "
+      + countIf("\"astType\" = " + sqlValue(AstType::Definition)) + ", "
+      + countIf("\"astType\" = " + sqlValue(AstType::Declaration)
+        + " AND \"visibleInSourceCode\"") + ", "
+      "COUNT(*), "
+      + countIf("\"astType\" = " + sqlValue(AstType::Usage)) + ", "
+      + countIf("\"astType\" = " + sqlValue(AstType::Read)) + ", "
+      + countIf("\"astType\" = " + sqlValue(AstType::Write)) + ", "
+      + countIf("\"astType\" = " + sqlValue(AstType::UnDefinition)) +
+      " FROM \"CppAstNode\""
+      " WHERE \"location_range_end_line\" <> " + npos
+      + (condition_.empty() ? "" : " AND \"mangledNameHash\" " + condition_) +
+      " GROUP BY \"mangledNameHash\"";
+
+  // Callers are the function definitions which enclose a usage of the
+  // symbol.
+  const std::string callerSql
+    = "SELECT u.\"mangledNameHash\", COUNT(DISTINCT d.\"id\")"
+      " FROM \"CppAstNode\" u JOIN \"CppAstNode\" d"
+      " ON d.\"location_file\" = u.\"location_file\""
+      " WHERE u.\"astType\" = " + sqlValue(AstType::Usage) +
+      " AND u.\"location_range_end_line\" <> " + npos
+      + (condition_.empty() ? "" : " AND u.\"mangledNameHash\" " + condition_) +
+      " AND d.\"astType\" = " + sqlValue(AstType::Definition) +
+      " AND d.\"symbolType\" = " + sqlValue(SymbolType::Function) +
+      " AND d.\"location_range_end_line\" <> " + npos +
+      // StartPos <= Pos
+      " AND (d.\"location_range_start_line\" < u.\"location_range_start_line\""
+      " OR (d.\"location_range_start_line\" = u.\"location_range_start_line\""
+      " AND d.\"location_range_start_column\""
+      " <= u.\"location_range_start_column\"))"
+      // Pos < EndPos
+      " AND (d.\"location_range_end_line\" > u.\"location_range_end_line\""
+      " OR (d.\"location_range_end_line\" = u.\"location_range_end_line\""
+      " AND d.\"location_range_end_column\""
+      " > u.\"location_range_end_column\"))"
+      " GROUP BY u.\"mangledNameHash\"";
+
+  for (const cc::model::CppAstNodeCountByType& row
+    : db_.query<cc::model::CppAstNodeCountByType>(byTypeSql))
+  {
+    cc::model::CppReferenceCountPtr& count
+      = getCount(counts_, row.mangledNameHash);
+
+    count->definition = row.definition;
+    count->declaration = row.declaration;
+    count->usage = row.usage;
+    count->callsOfThis = row.callsOfThis;
+    count->read = row.read;
+    count->write = row.write;
+    count->undefinition = row.undefinition;
+  }
+
+  for (const cc::model::CppSymbolCount& row
+    : db_.query<cc::model::CppSymbolCount>(callerSql))
+    getCount(counts_, row.mangledNameHash)->caller = row.count;
+}
+
+/**
+ * This function builds the override graph and its reverse from the Override
+ * relations.
+ */
+void loadOverrides(odb::database& db_, Graph& overrides_, Graph& overriddenBy_)
+{
+  for (const cc::model::CppRelation& relation
+    : db_.query<cc::model::CppRelation>(
+        odb::query<cc::model::CppRelation>::kind
+          == cc::model::CppRelation::Kind::Override))
+  {
+    overrides_[relation.lhs].push_back(relation.rhs);
+    overriddenBy_[relation.rhs].push_back(relation.lhs);
+  }
+}
+
+}
+
+namespace cc
+{
+namespace parser
+{
+
+ReferenceCounter::ReferenceCounter(std::shared_ptr<odb::database> db_)
+  : _db(db_)
+{
+}
+
+void ReferenceCounter::count()
+{
+  util::OdbTransaction {_db} ([this] {
+    Counts counts;
+
+    countAstNodes(*_db, std::string(), counts);
+
+    //--- Overrides ---//
+
+    Graph overrides;
+    Graph overriddenBy;
+
+    loadOverrides(*_db, overrides, overriddenBy);
+
+    for (const Graph::value_type& node : overrides)
+      getCount(counts, node.first)->overrides
+        = closureSize(overrides, node.first);
+
+    for (const Graph::value_type& node : overriddenBy)
+      getCount(counts, node.first)->overriddenBy
+        = closureSize(overriddenBy, node.first);
+
+    //--- Store the result ---//
+
+    std::vector<model::CppReferenceCountPtr> result;
+    result.reserve(counts.size());
+
+    for (const auto& count : counts)
+      result.push_back(count.second);
+
+    _db->erase_query<model::CppReferenceCount>();
+    util::persistAll(result, _db);
+
+    LOG(debug)
+      << "[cppparser] Reference counts of " << result.size()
+      << " symbols computed.";
+  });
+}
+
+void ReferenceCounter::count(const std::unordered_set<std::uint64_t>& symbols_)
+{
+  typedef odb::query<model::CppReferenceCount> CountQuery;
+
+  const std::vector<std::uint64_t> symbols(symbols_.begin(), symbols_.end());
+
+  util::OdbTransaction {_db} ([&, this] {
+    Counts counts;
+
+    forEachChunk(symbols, [&, this](
+      std::vector<std::uint64_t>::const_iterator,
+      std::vector<std::uint64_t>::const_iterator,
+      const std::string& list_)
+    {
+      countAstNodes(*_db, "IN " + list_, counts);
+    });
+
+    //--- Overrides ---//
+
+    // An Override relation changes the closure of every symbol which reaches
+    // it, so the override counts of the other symbols are updated too. Only
+    // the rows of the symbols with overrides are loaded for this.
+
+    Graph overrides;
+    Graph overriddenBy;
+
+    loadOverrides(*_db, overrides, overriddenBy);
+
+    Counts stored;
+
+    for (const model::CppReferenceCount& count
+      : _db->query<model::CppReferenceCount>(
+          CountQuery::overrides > 0 || CountQuery::overriddenBy > 0))
+      if (!symbols_.count(count.mangledNameHash))
+        stored.emplace(
+          count.mangledNameHash,
+          std::make_shared<model::CppReferenceCount>(count));
+
+    auto getOverrideCount = [&, this](std::uint64_t mangledNameHash_)
+    {
+      if (symbols_.count(mangledNameHash_))
+        return getCount(counts, mangledNameHash_);
+
+      model::CppReferenceCountPtr& count = stored[mangledNameHash_];
+
+      if (!count)
+      {
+        count = _db->find<model::CppReferenceCount>(mangledNameHash_);
+
+        if (!count)
+          count = getCount(counts, mangledNameHash_);
+      }
+
+      return count;
+    };
+
+    std::unordered_map<std::uint64_t, std::pair<std::size_t, std::size_t>>
+      prevOverrides;
+
+    for (const Counts::value_type& count : stored)
+      prevOverrides.emplace(
+        count.first,
+        std::make_pair(count.second->overrides, count.second->overriddenBy));
+
+    for (const Counts::value_type& count : stored)
+      count.second->overrides = count.second->overriddenBy = 0;
+
+    for (const Graph::value_type& node : overrides)
+      getOverrideCount(node.first)->overrides
+        = closureSize(overrides, node.first);
+
+    for (const Graph::value_type& node : overriddenBy)
+      getOverrideCount(node.first)->overriddenBy
+        = closureSize(overriddenBy, node.first);
+
+    //--- Store the result ---//
+
+    forEachChunk(symbols, [this](
+      std::vector<std::uint64_t>::const_iterator begin_,
+      std::vector<std::uint64_t>::const_iterator end_,
+      const std::string&)
+    {
+      _db->erase_query<model::CppReferenceCount>(
+        CountQuery::mangledNameHash.in_range(begin_, end_));
+    });
+
+    std::vector<model::CppReferenceCountPtr> result;
+    result.reserve(counts.size());
+
+    for (const auto& count : counts)
+      result.push_back(count.second);
+
+    util::persistAll(result, _db);
+
+    std::size_t updated = 0;
+
+    for (const Counts::value_type& count : stored)
+    {
+      if (counts.count(count.first))
+        continue;
+
+      auto prev = prevOverrides.find(count.first);
+
+      if (prev == prevOverrides.end() ||
+          prev->second.first != count.second->overrides ||
+          prev->second.second != count.second->overriddenBy)
+      {
+        _db->update(*count.second);
+        ++updated;
+      }
+    }
+
+    LOG(debug)
+      << "[cppparser] Reference counts of " << result.size()
+      << " symbols computed, override counts of " << updated
+      << " symbols updated.";
+  });
+}
+
+void ReferenceCounter::collectSymbols(
+  const std::vector<model::FileId>& files_,
+  std::unordered_set<std::uint64_t>& symbols_)
+{
+  util::OdbTransaction {_db} ([&, this] {
+    forEachChunk(files_, [&, this](
+      std::vector<std::uint64_t>::const_iterator,
+      std::vector<std::uint64_t>::const_iterator,
+      const std::string& list_)
+    {
+      for (const model::CppSymbolCount& row
+        : _db->query<model::CppSymbolCount>(
+            "SELECT \"mangledNameHash\", COUNT(*) FROM \"CppAstNode\""
+            " WHERE \"location_file\" IN " + list_ +
+            " GROUP BY \"mangledNameHash\""))
+        symbols_.insert(row.mangledNameHash);
+    });
+  });
+}
+
+} // parser
+} // cc
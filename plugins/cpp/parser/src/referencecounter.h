@@ -0,0 +1,60 @@
+#ifndef CC_PARSER_REFERENCECOUNTER_H
+#define CC_PARSER_REFERENCECOUNTER_H
+
+#include <cstdint>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include <odb/database.hxx>
+
+#include <model/file.h>
+
+namespace cc
+{
+namespace parser
+{
+
+/**
+ * This class fills the CppReferenceCount table, which contains the number of
+ * references of the symbols by reference kind. After a full parse or merging
+ * databases the table is recomputed from scratch. After an incremental parse
+ * only the symbols which have AST nodes in the changed files are counted
+ * again, because the counts of the other symbols can't change.
+ */
+class ReferenceCounter
+{
+public:
+  ReferenceCounter(std::shared_ptr<odb::database> db_);
+
+  /**
+   * This function counts the references and replaces the content of the
+   * CppReferenceCount table with the result.
+   */
+  void count();
+
+  /**
+   * This function counts the references of the given symbols and replaces
+   * their rows in the CppReferenceCount table. The override counts depend on
+   * the relations of the whole project, so these are updated for every
+   * symbol.
+   * @param symbols_ Mangled name hashes of the symbols.
+   */
+  void count(const std::unordered_set<std::uint64_t>& symbols_);
+
+  /**
+   * This function adds the mangled name hashes of the symbols which have AST
+   * nodes in the given files to symbols_.
+   */
+  void collectSymbols(
+    const std::vector<model::FileId>& files_,
+    std::unordered_set<std::uint64_t>& symbols_);
+
+private:
+  std::shared_ptr<odb::database> _db;
+};
+
+} // parser
+} // cc
+
+#endif // CC_PARSER_REFERENCECOUNTER_H
@@ -1,9 +1,13 @@
 #ifndef CC_SERVICE_LANGUAGE_CPPSERVICE_H
 #define CC_SERVICE_LANGUAGE_CPPSERVICE_H
 
+#include <ctime>
 #include <memory>
+#include <mutex>
+#include <tuple>
 #include <vector>
 #include <map>
+#include <set>
 #include <unordered_set>
 #include <string>
 
@@ -17,8 +21,11 @@
 #include <model/cppastnode-odb.hxx>
 #include <model/cpprelation.h>
 #include <model/cpprelation-odb.hxx>
+#include <model/cpptype.h>
+#include <model/cpptype-odb.hxx>
 
 #include <util/odbtransaction.h>
+#include <webserver/projectgeneration.h>
 #include <webserver/servercontext.h>
 
 namespace cc
@@ -28,6 +35,10 @@ namespace service
 namespace language
 {
 
+class AstNodeIndexCache;
+class DiagramCache;
+class SyntaxHighlightCache;
+
 class CppServiceHandler : virtual public LanguageServiceIf
 {
   friend class Diagram;
@@ -271,6 +282,27 @@ private:
     const model::CppAstNode& lhs,
     const model::CppAstNode& rhs);
 
+  /**
+   * This function sets query_ to the condition which selects the references of
+   * the given kind among the AST nodes having the same mangled name. It returns
+   * false if the references of this kind can't be queried by a single AST node
+   * query.
+   */
+  static bool astReferenceQuery(
+    const std::int32_t referenceId_,
+    odb::query<model::CppAstNode>& query_);
+
+  /**
+   * This function looks up the number of references of the given kind in the
+   * counts precomputed by the parser (see model::CppReferenceCount). It returns
+   * false if the count of this kind is not precomputed or the symbol has no
+   * precomputed counts, in which case the references have to be counted.
+   */
+  bool queryReferenceCount(
+    std::uint64_t mangledNameHash_,
+    const std::int32_t referenceId_,
+    std::size_t& count_);
+
   /**
    * This function returns the corresponding model::CppAstNode to the given AST
    * node.
@@ -315,6 +347,35 @@ private:
   std::vector<model::CppAstNode> queryDefinitions(
     const core::AstNodeId& astNodeId_);
 
+  /**
+   * This function returns the definitions of the entities with the given
+   * mangled name hashes using a constant number of queries.
+   */
+  std::vector<model::CppAstNode> queryDefinitions(
+    const std::set<std::uint64_t>& mangledNameHashes_);
+
+  /**
+   * This function returns the members of the given kind of a type.
+   */
+  std::vector<model::CppAstNode> queryMembers(
+    const model::CppAstNode& node_,
+    model::CppMemberType::Kind kind_);
+
+  /**
+   * This function returns the definitions of the types of the given variables
+   * like getReferences() with TYPE reference, but it uses a constant number of
+   * queries for all variables. The result is indexed by the variable IDs.
+   */
+  std::map<core::AstNodeId, std::vector<AstNodeInfo>> getTypeDefinitions(
+    const std::vector<AstNodeInfo>& variables_);
+
+  /**
+   * This function returns the qualified types of the given variables indexed
+   * by their mangled name hashes using a constant number of queries.
+   */
+  std::map<std::uint64_t, std::string> getVariableTypes(
+    const std::vector<AstNodeInfo>& variables_);
+
   /**
    * This function returns an AST query to get the function calls in the given
    * function.
@@ -385,6 +446,54 @@ private:
 
   std::shared_ptr<std::string> _datadir;
   const cc::webserver::ServerContext& _context;
+
+  /**
+   * Generation of the parsed data. The stored results below are valid within
+   * one generation.
+   */
+  std::shared_ptr<cc::webserver::ProjectGeneration> _generation;
+
+  /**
+   * Position lookup indexes of the files, see getAstNodeInfoByPosition().
+   */
+  std::shared_ptr<AstNodeIndexCache> _astNodeIndexCache;
+
+  /**
+   * Stored highlights of the file contents, see getSyntaxHighlight().
+   */
+  std::shared_ptr<SyntaxHighlightCache> _syntaxHighlightCache;
+
+  /**
+   * Rendered diagrams, see getDiagram() and getFileDiagram().
+   */
+  std::shared_ptr<DiagramCache> _diagramCache;
+
+  /**
+   * Sort key of the last reference on a page returned by getReferencesPage().
+   * The next page is continued from this key.
+   */
+  struct PageCursor
+  {
+    model::FileId file;
+    model::Position start;
+    model::CppAstNodeId id;
+  };
+
+  /**
+   * Mangled name hash, reference kind, page size and page number.
+   */
+  typedef std::tuple<std::uint64_t, std::int32_t, std::int32_t, std::int32_t>
+    PageKey;
+
+  static constexpr std::size_t maxPageCursors = 4096;
+
+  std::mutex _pageCursorMutex;
+  std::map<PageKey, PageCursor> _pageCursors;
+
+  /**
+   * The generation of the parsed data when the cursors were stored.
+   */
+  std::time_t _pageCursorGeneration;
 };
 
 }
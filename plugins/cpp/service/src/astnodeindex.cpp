@@ -0,0 +1,203 @@
+#include <algorithm>
+
+#include <model/filecontent.h>
+#include <model/filecontent-odb.hxx>
+
+#include "astnodeindex.h"
+
+namespace cc
+{
+namespace service
+{
+namespace language
+{
+
+AstNodeIndex::AstNodeIndex(std::vector<Entry> entries_)
+  : _entries(std::move(entries_))
+{
+  std::stable_sort(_entries.begin(), _entries.end(),
+    [](const Entry& lhs_, const Entry& rhs_) {
+      return lhs_.range.start < rhs_.range.start;
+    });
+
+  _maxEnd.resize(_entries.size());
+
+  // The subtrees are computed bottom-up by a recursive lambda on the same
+  // subarrays which are visited by collect().
+  std::function<void(std::size_t, std::size_t)> build
+    = [&](std::size_t begin_, std::size_t end_)
+    {
+      if (begin_ >= end_)
+        return;
+
+      std::size_t mid = begin_ + (end_ - begin_) / 2;
+
+      build(begin_, mid);
+      build(mid + 1, end_);
+
+      model::Position maxEnd = _entries[mid].range.end;
+
+      if (begin_ < mid)
+        maxEnd = std::max(maxEnd, _maxEnd[begin_ + (mid - begin_) / 2]);
+
+      if (mid + 1 < end_)
+        maxEnd = std::max(maxEnd, _maxEnd[mid + 1 + (end_ - mid - 1) / 2]);
+
+      _maxEnd[mid] = maxEnd;
+    };
+
+  build(0, _entries.size());
+}
+
+void AstNodeIndex::collect(
+  std::size_t begin_,
+  std::size_t end_,
+  const model::Position& pos_,
+  std::vector<const Entry*>& result_) const
+{
+  if (begin_ >= end_)
+    return;
+
+  std::size_t mid = begin_ + (end_ - begin_) / 2;
+
+  // None of the nodes in this subtree ends after the position.
+  if (!(pos_ < _maxEnd[mid]))
+    return;
+
+  collect(begin_, mid, pos_, result_);
+
+  // The nodes of the right subtree start after the position.
+  if (pos_ < _entries[mid].range.start)
+    return;
+
+  if (pos_ < _entries[mid].range.end)
+    result_.push_back(&_entries[mid]);
+
+  collect(mid + 1, end_, pos_, result_);
+}
+
+model::CppAstNodeId AstNodeIndex::innermost(const model::Position& pos_) const
+{
+  std::vector<const Entry*> nodes;
+  collect(0, _entries.size(), pos_, nodes);
+
+  model::Range minRange(model::Position(0, 0), model::Position());
+  model::CppAstNodeId min = 0;
+
+  for (const Entry* node : nodes)
+  {
+    if (node->isMacro)
+      return node->id;
+
+    if (node->visibleInSourceCode && node->range < minRange)
+    {
+      min = node->id;
+      minRange = node->range;
+    }
+  }
+
+  return min;
+}
+
+std::size_t AstNodeIndex::size() const
+{
+  return _entries.size();
+}
+
+AstNodeIndexCache::AstNodeIndexCache(
+  std::shared_ptr<webserver::ProjectGeneration> generation_,
+  std::size_t capacity_)
+  : _generation(generation_),
+    _capacity(capacity_),
+    _size(0),
+    _current(_generation->get())
+{
+}
+
+std::shared_ptr<const AstNodeIndex> AstNodeIndexCache::get(
+  const model::File& file_,
+  const Builder& builder_)
+{
+  const Version version{file_.timestamp, file_.content.object_id()};
+  std::time_t generation;
+
+  {
+    std::lock_guard<std::mutex> guard(_mutex);
+
+    checkGeneration();
+    generation = _current;
+
+    auto it = _items.find(file_.id);
+
+    if (it != _items.end())
+    {
+      if (it->second.version == version)
+      {
+        _lru.splice(_lru.begin(), _lru, it->second.lruPos);
+        return it->second.index;
+      }
+
+      _size -= it->second.index->size();
+      _lru.erase(it->second.lruPos);
+      _items.erase(it);
+    }
+  }
+
+  // The index is built without holding the lock, so that the queries of
+  // other files are not blocked.
+  auto index = std::make_shared<const AstNodeIndex>(builder_());
+
+  std::lock_guard<std::mutex> guard(_mutex);
+
+  // The index may have been built from the data of the previous generation.
+  checkGeneration();
+  if (generation != _current)
+    return index;
+
+  auto it = _items.find(file_.id);
+
+  if (it != _items.end())
+  {
+    _size -= it->second.index->size();
+    _lru.erase(it->second.lruPos);
+    _items.erase(it);
+  }
+
+  _lru.push_front(file_.id);
+  _items[file_.id] = Item{index, version, _lru.begin()};
+  _size += index->size();
+
+  evict();
+
+  return index;
+}
+
+void AstNodeIndexCache::checkGeneration()
+{
+  std::time_t generation = _generation->get();
+
+  if (generation == _current)
+    return;
+
+  _current = generation;
+  _items.clear();
+  _lru.clear();
+  _size = 0;
+}
+
+void AstNodeIndexCache::evict()
+{
+  // The most recently used index is kept even if it exceeds the capacity.
+  while (_size > _capacity && _lru.size() > 1)
+  {
+    auto it = _items.find(_lru.back());
+
+    _size -= it->second.index->size();
+    _items.erase(it);
+    _lru.pop_back();
+  }
+}
+
+} // language
+} // service
+} // cc
@@ -0,0 +1,145 @@
+#ifndef CC_SERVICE_LANGUAGE_ASTNODEINDEX_H
+#define CC_SERVICE_LANGUAGE_ASTNODEINDEX_H
+
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <model/cppastnode.h>
+#include <model/file.h>
+#include <model/position.h>
+
+#include <webserver/projectgeneration.h>
+
+namespace cc
+{
+namespace service
+{
+namespace language
+{
+
+/**
+ * Interval tree of the AST nodes of a file for answering which node is under
+ * a given position.
+ *
+ * The nodes are sorted by their start position, and the sorted array is
+ * treated as an implicit balanced binary tree: the root of a subarray is its
+ * middle element. Every element stores the greatest end position of its
+ * subtree, so the subtrees ending before the queried position can be skipped.
+ * A query takes O(log n + k) time where k is the number of nodes containing
+ * the position.
+ */
+class AstNodeIndex
+{
+public:
+  struct Entry
+  {
+    model::Range range;
+    model::CppAstNodeId id;
+    bool isMacro;
+    bool visibleInSourceCode;
+  };
+
+  AstNodeIndex(std::vector<Entry> entries_);
+
+  /**
+   * This function returns the ID of the innermost visible AST node containing
+   * the given position. Macro expansions take precedence over other nodes.
+   * If there is no such node then 0 returns.
+   */
+  model::CppAstNodeId innermost(const model::Position& pos_) const;
+
+  std::size_t size() const;
+
+private:
+  void collect(
+    std::size_t begin_,
+    std::size_t end_,
+    const model::Position& pos_,
+    std::vector<const Entry*>& result_) const;
+
+  std::vector<Entry> _entries;
+
+  /**
+   * The greatest end position in the subtree of the corresponding entry.
+   */
+  std::vector<model::Position> _maxEnd;
+};
+
+/**
+ * Thread safe LRU cache of AstNodeIndex objects by file.
+ *
+ * An index is valid as long as the timestamp and the content of the file are
+ * unchanged, so the index of a reparsed file is rebuilt at the next query.
+ * The nodes of an unchanged header may change too when a file including it is
+ * reparsed, so the whole cache is cleared when the generation of the project
+ * changes. The least recently used indexes are evicted when the total number
+ * of nodes in the cache exceeds the capacity.
+ */
+class AstNodeIndexCache
+{
+public:
+  typedef std::function<std::vector<AstNodeIndex::Entry>()> Builder;
+
+  AstNodeIndexCache(
+    std::shared_ptr<webserver::ProjectGeneration> generation_,
+    std::size_t capacity_ = 2000000);
+
+  /**
+   * This function returns the index of the given file. If it is not cached or
+   * the file has changed since the index was built, then a new index is
+   * built by the builder function.
+   */
+  std::shared_ptr<const AstNodeIndex> get(
+    const model::File& file_,
+    const Builder& builder_);
+
+private:
+  struct Version
+  {
+    std::uint64_t timestamp;
+    std::string content;
+
+    bool operator==(const Version& other_) const
+    {
+      return timestamp == other_.timestamp && content == other_.content;
+    }
+  };
+
+  struct Item
+  {
+    std::shared_ptr<const AstNodeIndex> index;
+    Version version;
+    std::list<model::FileId>::iterator lruPos;
+  };
+
+  void evict();
+
+  /**
+   * This function clears the cache if the generation of the project has
+   * changed since the indexes were built.
+   */
+  void checkGeneration();
+
+  std::shared_ptr<webserver::ProjectGeneration> _generation;
+
+  const std::size_t _capacity;
+  std::size_t _size;
+  std::time_t _current;
+
+  std::mutex _mutex;
+  std::list<model::FileId> _lru;
+  std::unordered_map<model::FileId, Item> _items;
+};
+
+} // language
+} // service
+} // cc
+
+#endif // CC_SERVICE_LANGUAGE_ASTNODEINDEX_H
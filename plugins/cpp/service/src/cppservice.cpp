@@ -1,5 +1,6 @@
 #include <algorithm>
-#include <queue>
+#include <set>
+#include <unordered_map>
 
 #include <util/util.h>
 #include <util/logutil.h>
@@ -22,11 +23,16 @@
 #include <model/cppmacroexpansion-odb.hxx>
 #include <model/cppdoccomment.h>
 #include <model/cppdoccomment-odb.hxx>
+#include <model/cppreferencecount.h>
+#include <model/cppreferencecount-odb.hxx>
 
 #include <service/cppservice.h>
 
+#include "astnodeindex.h"
 #include "diagram.h"
+#include "diagramcache.h"
 #include "filediagram.h"
+#include "syntaxhighlight.h"
 
 namespace
 {
@@ -103,6 +109,42 @@ namespace
     const std::map<cc::model::CppAstNodeId, std::vector<std::string>>& _tags;
     std::shared_ptr<odb::database> _db;
   };
+
+  /**
+   * Maximal number of values in the IN list of a query. The number of host
+   * parameters of a statement is limited by some databases (e.g. SQLite).
+   */
+  const std::size_t maxInListSize = 500;
+
+  /**
+   * This function runs a query for the objects whose given column has one of
+   * the given values and meet the given query condition. The IN list is split
+   * to chunks, so the number of queries doesn't depend on the number of
+   * objects. The given function is called for every resulting object. The
+   * type of the objects has to be given explicitly, because the conditions of
+   * ODB queries are not of odb::query<T> type.
+   */
+  template <typename T, typename Column, typename Values, typename Func>
+  void queryInChunks(
+    odb::database& db_,
+    const Column& column_,
+    const Values& values_,
+    const odb::query<T>& query_,
+    Func func_)
+  {
+    std::vector<typename Values::value_type> values(
+      values_.begin(), values_.end());
+
+    for (std::size_t i = 0; i < values.size(); i += maxInListSize)
+    {
+      auto begin = values.begin() + i;
+      auto end = values.begin() + std::min(i + maxInListSize, values.size());
+
+      for (const T& object
+        : db_.query<T>(column_.in_range(begin, end) && query_))
+        func_(object);
+    }
+  }
 }
 
 namespace cc
@@ -119,7 +161,15 @@ CppServiceHandler::CppServiceHandler(
     : _db(db_),
       _transaction(db_),
       _datadir(datadir_),
-      _context(context_)
+      _context(context_),
+      _generation(std::make_shared<cc::webserver::ProjectGeneration>(
+        *datadir_ + "/project_info.json")),
+      _astNodeIndexCache(std::make_shared<AstNodeIndexCache>(_generation)),
+      _syntaxHighlightCache(std::make_shared<SyntaxHighlightCache>(
+        *datadir_ + "/cppsyntaxhighlight", _generation)),
+      _diagramCache(std::make_shared<DiagramCache>(
+        *datadir_ + "/cppdiagram", _generation)),
+      _pageCursorGeneration(0)
 {
 }
 
@@ -224,41 +274,45 @@ void CppServiceHandler::getAstNodeInfoByPosition(
   const core::FilePosition& fpos_)
 {
   _transaction([&, this](){
-    //--- Query nodes at the given position ---//
-
-    AstResult nodes = _db->query<model::CppAstNode>(
-      AstQuery::location.file == std::stoull(fpos_.file) &&
-      // StartPos <= Pos
-      ((AstQuery::location.range.start.line == fpos_.pos.line &&
-        AstQuery::location.range.start.column <= fpos_.pos.column) ||
-       AstQuery::location.range.start.line < fpos_.pos.line) &&
-      // Pos < EndPos
-      ((AstQuery::location.range.end.line == fpos_.pos.line &&
-        AstQuery::location.range.end.column > fpos_.pos.column) ||
-       AstQuery::location.range.end.line > fpos_.pos.line));
+    //--- Find the index of the file ---//
 
-    //--- Select innermost clickable node ---//
-
-    model::Range minRange(model::Position(0, 0), model::Position());
     model::CppAstNode min;
+    model::File file;
 
-    for (const model::CppAstNode& node : nodes)
+    if (!_db->find(std::stoull(fpos_.file), file))
     {
-      // TODO: Remove ugly hack and use CppAstNode::visibleInSourceCode when it
-      // will be available.
-      if (node.symbolType == model::CppAstNode::SymbolType::Macro)
-      {
-        min = node;
-        break;
-      }
-
-      if (node.visibleInSourceCode && node.location.range < minRange)
-      {
-        min = node;
-        minRange = node.location.range;
-      }
+      return_ = CreateAstNodeInfo(getTags({min}))(min);
+      return;
     }
 
+    std::shared_ptr<const AstNodeIndex> index = _astNodeIndexCache->get(
+      file,
+      [&, this](){
+        std::vector<AstNodeIndex::Entry> entries;
+
+        for (const model::CppAstNode& node : _db->query<model::CppAstNode>(
+          AstQuery::location.file == file.id))
+        {
+          // TODO: Remove ugly hack and use CppAstNode::visibleInSourceCode
+          // when it will be available.
+          entries.push_back(AstNodeIndex::Entry{
+            node.location.range,
+            node.id,
+            node.symbolType == model::CppAstNode::SymbolType::Macro,
+            node.visibleInSourceCode});
+        }
+
+        return entries;
+      });
+
+    //--- Select innermost clickable node ---//
+
+    model::CppAstNodeId id = index->innermost(
+      model::Position(fpos_.pos.line, fpos_.pos.column));
+
+    if (id)
+      _db->find(id, min);
+
     return_ = _transaction([this, &min](){
       return CreateAstNodeInfo(getTags({min}))(min);
     });
@@ -351,27 +405,21 @@ std::int32_t CppServiceHandler::getReferenceCount(
   model::CppAstNode node = queryCppAstNode(astNodeId_);
 
   return _transaction([&, this]() -> std::int32_t {
-    switch (referenceId_)
-    {
-      case DEFINITION:
-        return queryCppAstNodeCount(astNodeId_,
-          AstQuery::astType == model::CppAstNode::AstType::Definition);
-
-      case DECLARATION:
-        return queryCppAstNodeCount(astNodeId_,
-          AstQuery::astType == model::CppAstNode::AstType::Declaration &&
-          AstQuery::visibleInSourceCode == true);
+    std::size_t count;
+    if (queryReferenceCount(node.mangledNameHash, referenceId_, count))
+      return count;
 
-      case USAGE:
-        return queryCppAstNodeCount(astNodeId_);
+    // These are counted by the same condition as getReferencesPage() lists
+    // them.
+    AstQuery query(true);
+    if (astReferenceQuery(referenceId_, query))
+      return queryCppAstNodeCount(astNodeId_, query);
 
+    switch (referenceId_)
+    {
       case THIS_CALLS:
         return queryCallsCount(astNodeId_);
 
-      case CALLS_OF_THIS:
-        return queryCppAstNodeCount(astNodeId_,
-          AstQuery::astType == model::CppAstNode::AstType::Usage);
-
       case CALLEE:
       {
         std::int32_t count = 0;
@@ -462,14 +510,6 @@ std::int32_t CppServiceHandler::getReferenceCount(
       case OVERRIDDEN_BY:
         return queryOverridesCount(astNodeId_, false);
 
-      case READ:
-        return queryCppAstNodeCount(astNodeId_,
-          AstQuery::astType == model::CppAstNode::AstType::Read);
-
-      case WRITE:
-        return queryCppAstNodeCount(astNodeId_,
-          AstQuery::astType == model::CppAstNode::AstType::Write);
-
       case TYPE:
       {
         node = queryCppAstNode(astNodeId_);
@@ -523,10 +563,6 @@ std::int32_t CppServiceHandler::getReferenceCount(
         return _db->query_value<model::CppMacroExpansionCount>(
           MacroExpansionQuery::astNodeId == node.id).count;
 
-      case UNDEFINITION:
-        return queryCppAstNodeCount(astNodeId_,
-          AstQuery::astType == model::CppAstNode::AstType::UnDefinition);
-
       default:
         return 0;
     }
@@ -628,47 +664,67 @@ void CppServiceHandler::getReferences(
         break;
 
       case CALLEE:
+      {
+        std::set<std::uint64_t> calleeHashes;
         for (const model::CppAstNode& call : queryCalls(astNodeId_))
-        {
-          core::AstNodeId astNodeId = std::to_string(call.id);
-          std::vector<model::CppAstNode> defs = queryDefinitions(astNodeId);
-          nodes.insert(nodes.end(), defs.begin(), defs.end());
-        }
+          calleeHashes.insert(call.mangledNameHash);
+
+        nodes = queryDefinitions(calleeHashes);
 
         std::sort(nodes.begin(), nodes.end());
         nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
 
         break;
+      }
 
       case CALLER:
-        for (const model::CppAstNode& astNode : queryCppAstNodes(
+      {
+        std::vector<model::CppAstNode> usages = queryCppAstNodes(
           astNodeId_,
-          AstQuery::astType == model::CppAstNode::AstType::Usage))
+          AstQuery::astType == model::CppAstNode::AstType::Usage);
+
+        // The function definitions of the files of the usages are fetched at
+        // once, and the ones enclosing a usage are selected here.
+        std::set<model::FileId> files;
+        for (const model::CppAstNode& usage : usages)
+          if (usage.location.file)
+            files.insert(usage.location.file.object_id());
+
+        std::map<model::FileId, std::vector<model::CppAstNode>> functions;
+
+        queryInChunks<model::CppAstNode>(
+          *_db, AstQuery::location.file, files,
+          AstQuery::astType == model::CppAstNode::AstType::Definition &&
+          AstQuery::symbolType == model::CppAstNode::SymbolType::Function &&
+          AstQuery::location.range.end.line != model::Position::npos,
+          [&functions](const model::CppAstNode& function_) {
+            functions[function_.location.file.object_id()].push_back(
+              function_);
+          });
+
+        for (const model::CppAstNode& usage : usages)
         {
-          const model::Position& start = astNode.location.range.start;
-          const model::Position& end   = astNode.location.range.end;
+          if (!usage.location.file)
+            continue;
 
-          AstResult result = _db->query<model::CppAstNode>(
-            AstQuery::astType    == model::CppAstNode::AstType::Definition &&
-            AstQuery::symbolType == model::CppAstNode::SymbolType::Function &&
-            // Same file
-            AstQuery::location.file == astNode.location.file.object_id() &&
-            // StartPos >= Pos
-            ((AstQuery::location.range.start.line == start.line &&
-              AstQuery::location.range.start.column <= start.column) ||
-             AstQuery::location.range.start.line < start.line) &&
-            // Pos > EndPos
-            ((AstQuery::location.range.end.line == end.line &&
-              AstQuery::location.range.end.column > end.column) ||
-             AstQuery::location.range.end.line > end.line));
+          const model::Range& range = usage.location.range;
 
-          nodes.insert(nodes.end(), result.begin(), result.end());
+          for (const model::CppAstNode& function
+            : functions[usage.location.file.object_id()])
+          {
+            const model::Range& funcRange = function.location.range;
+
+            // StartPos <= Pos && Pos < EndPos
+            if (!(range.start < funcRange.start) && range.end < funcRange.end)
+              nodes.push_back(function);
+          }
         }
 
         std::sort(nodes.begin(), nodes.end());
         nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
 
         break;
+      }
 
       case VIRTUAL_CALL:
       {
@@ -852,34 +908,20 @@ void CppServiceHandler::getReferences(
       case DATA_MEMBER:
         node = queryCppAstNode(astNodeId_);
 
-        for (const model::CppMemberType& mem : _db->query<model::CppMemberType>(
-          MemTypeQuery::typeHash == node.mangledNameHash &&
-          MemTypeQuery::kind == model::CppMemberType::Kind::Field))
-          // TODO: Filter by tags
-        {
-          model::CppAstNodePtr astNode = mem.memberAstNode.load();
-
-          if (astNode->location.range.end.line != model::Position::npos)
-            nodes.push_back(*astNode);
-        }
+        nodes = queryMembers(node, model::CppMemberType::Kind::Field);
+        nodes.erase(
+          std::remove_if(nodes.begin(), nodes.end(),
+            [](const model::CppAstNode& member_) {
+              return member_.location.range.end.line == model::Position::npos;
+            }),
+          nodes.end());
 
         break;
 
       case METHOD:
-      {
         node = queryCppAstNode(astNodeId_);
-
-        for (const model::CppMemberType& mem : _db->query<model::CppMemberType>(
-          MemTypeQuery::typeHash == node.mangledNameHash &&
-          MemTypeQuery::kind == model::CppMemberType::Kind::Method))
-          // TODO: Filter by tags
-        {
-          model::CppAstNodePtr astNode = mem.memberAstNode.load();
-          nodes.push_back(*astNode);
-        }
-
+        nodes = queryMembers(node, model::CppMemberType::Kind::Method);
         break;
-      }
 
       case FRIEND:
         node = queryCppAstNode(astNodeId_);
@@ -1001,13 +1043,122 @@ void CppServiceHandler::getReferencesInFile(
 }
 
 void CppServiceHandler::getReferencesPage(
-  std::vector<AstNodeInfo>& /* return_ */,
-  const core::AstNodeId& /* astNodeId_ */,
-  const std::int32_t /* referenceId_ */,
-  const std::int32_t /* pageSize_ */,
-  const std::int32_t /* pageNo_ */)
+  std::vector<AstNodeInfo>& return_,
+  const core::AstNodeId& astNodeId_,
+  const std::int32_t referenceId_,
+  const std::int32_t pageSize_,
+  const std::int32_t pageNo_)
 {
-  // TODO
+  if (pageSize_ <= 0 || pageNo_ < 0)
+    return;
+
+  AstQuery query(true);
+
+  if (!astReferenceQuery(referenceId_, query))
+  {
+    // The other reference kinds are assembled from several queries and they
+    // are small, so these are paged in memory.
+    std::vector<AstNodeInfo> references;
+    getReferences(references, astNodeId_, referenceId_, {});
+
+    std::size_t begin = static_cast<std::size_t>(pageSize_) * pageNo_;
+    if (begin >= references.size())
+      return;
+
+    std::size_t end = std::min(begin + pageSize_, references.size());
+    return_.assign(
+      std::make_move_iterator(references.begin() + begin),
+      std::make_move_iterator(references.begin() + end));
+    return;
+  }
+
+  model::CppAstNode node = queryCppAstNode(astNodeId_);
+
+  // The cursors of the previous database content are dropped when the
+  // project is parsed again.
+  std::time_t generation = _generation->get();
+
+  // The references are ordered by (file, line, column, id). If the previous
+  // page has already been served then the query seeks right after its last
+  // element instead of skipping all the preceding rows.
+  PageKey prevKey(node.mangledNameHash, referenceId_, pageSize_, pageNo_ - 1);
+  PageCursor cursor;
+  bool seek = false;
+
+  {
+    std::lock_guard<std::mutex> lock(_pageCursorMutex);
+
+    if (generation != _pageCursorGeneration)
+    {
+      _pageCursors.clear();
+      _pageCursorGeneration = generation;
+    }
+
+    auto it = pageNo_ > 0 ? _pageCursors.find(prevKey) : _pageCursors.end();
+    if (it != _pageCursors.end())
+    {
+      cursor = it->second;
+      seek = true;
+    }
+  }
+
+  std::vector<model::CppAstNode> nodes;
+
+  _transaction([&, this](){
+    query = AstQuery::mangledNameHash == node.mangledNameHash &&
+      AstQuery::location.range.end.line != model::Position::npos &&
+      query;
+
+    if (seek)
+      query = query &&
+        (AstQuery::location.file > cursor.file ||
+         (AstQuery::location.file == cursor.file &&
+          (AstQuery::location.range.start.line > cursor.start.line ||
+           (AstQuery::location.range.start.line == cursor.start.line &&
+            (AstQuery::location.range.start.column > cursor.start.column ||
+             (AstQuery::location.range.start.column == cursor.start.column &&
+              AstQuery::id > cursor.id))))));
+
+    query = query
+      + "ORDER BY" + AstQuery::location.file
+      + "," + AstQuery::location.range.start.line
+      + "," + AstQuery::location.range.start.column
+      + "," + AstQuery::id
+      + "LIMIT" + AstQuery::_val(pageSize_);
+
+    if (!seek && pageNo_ > 0)
+      query = query + "OFFSET" + AstQuery::_val(
+        static_cast<std::int64_t>(pageSize_) * pageNo_);
+
+    AstResult result = _db->query<model::CppAstNode>(query);
+    nodes.assign(result.begin(), result.end());
+
+    return_.reserve(nodes.size());
+    std::transform(
+      nodes.begin(), nodes.end(),
+      std::back_inserter(return_),
+      CreateAstNodeInfo(getTags(nodes)));
+  });
+
+  if (nodes.empty())
+    return;
+
+  const model::CppAstNode& last = nodes.back();
+
+  cursor.file = last.location.file.object_id();
+  cursor.start = last.location.range.start;
+  cursor.id = last.id;
+
+  std::lock_guard<std::mutex> lock(_pageCursorMutex);
+
+  if (generation != _pageCursorGeneration)
+    return;
+
+  if (_pageCursors.size() >= maxPageCursors)
+    _pageCursors.clear();
+
+  _pageCursors[PageKey(
+    node.mangledNameHash, referenceId_, pageSize_, pageNo_)] = cursor;
 }
 
 void CppServiceHandler::getFileReferenceTypes(
@@ -1106,10 +1257,56 @@ std::int32_t CppServiceHandler::getFileReferenceCount(
 }
 
 void CppServiceHandler::getSyntaxHighlight(
-  std::vector<SyntaxHighlight>& /* return_ */,
-  const core::FileId& /* fileId_ */)
+  std::vector<SyntaxHighlight>& return_,
+  const core::FileId& fileId_)
 {
-  // TODO
+  std::vector<SyntaxHighlightCache::Token> tokens = _transaction([&, this](){
+    model::File file;
+
+    if (!_db->find(std::stoull(fileId_), file))
+    {
+      core::InvalidId ex;
+      ex.__set_msg("Invalid file ID");
+      ex.__set_fid(fileId_);
+      throw ex;
+    }
+
+    if (!file.content)
+      return std::vector<SyntaxHighlightCache::Token>();
+
+    return _syntaxHighlightCache->get(
+      file.content.object_id(),
+      [&, this](){
+        std::vector<SyntaxHighlightCache::Token> candidates;
+
+        for (const model::CppAstNode& node : _db->query<model::CppAstNode>(
+          AstQuery::location.file == file.id &&
+          AstQuery::visibleInSourceCode == true &&
+          AstQuery::symbolType != model::CppAstNode::SymbolType::Other))
+        {
+          candidates.push_back(SyntaxHighlightCache::Token{
+            node.location.range,
+            node.symbolType});
+        }
+
+        return candidates;
+      });
+  });
+
+  return_.reserve(tokens.size());
+
+  for (const SyntaxHighlightCache::Token& token : tokens)
+  {
+    SyntaxHighlight syntax;
+
+    syntax.range.startpos.line = token.range.start.line;
+    syntax.range.startpos.column = token.range.start.column;
+    syntax.range.endpos.line = token.range.end.line;
+    syntax.range.endpos.column = token.range.end.column;
+    syntax.className = SyntaxHighlightCache::cssClass(token.symbolType);
+
+    return_.push_back(std::move(syntax));
+  }
 }
 
 void CppServiceHandler::getDiagram(
@@ -1117,26 +1314,33 @@ void CppServiceHandler::getDiagram(
   const core::AstNodeId& astNodeId_,
   const std::int32_t diagramId_)
 {
-  Diagram diagram(_db, _datadir, _context);
-  util::Graph graph;
+  // The key is built from the numeric ID, so it is a valid file name.
+  const std::string key = "node-" + std::to_string(diagramId_) + '-'
+    + std::to_string(std::stoull(astNodeId_));
 
-  switch (diagramId_)
-  {
-    case FUNCTION_CALL:
-      diagram.getFunctionCallDiagram(graph, astNodeId_);
-      break;
+  return_ = _diagramCache->get(key, [&, this]{
+    Diagram diagram(_db, _datadir, _context);
+    util::Graph graph;
 
-    case DETAILED_CLASS:
-      diagram.getDetailedClassDiagram(graph, astNodeId_);
-      break;
+    switch (diagramId_)
+    {
+      case FUNCTION_CALL:
+        diagram.getFunctionCallDiagram(graph, astNodeId_);
+        break;
 
-    case CLASS_COLLABORATION:
-      diagram.getClassCollaborationDiagram(graph, astNodeId_);
-      break;
-  }
+      case DETAILED_CLASS:
+        diagram.getDetailedClassDiagram(graph, astNodeId_);
+        break;
 
-  if (graph.nodeCount() != 0)
-    return_ = graph.output(util::Graph::SVG);
+      case CLASS_COLLABORATION:
+        diagram.getClassCollaborationDiagram(graph, astNodeId_);
+        break;
+    }
+
+    return graph.nodeCount() != 0
+      ? graph.output(util::Graph::SVG)
+      : std::string();
+  });
 }
 
 void CppServiceHandler::getDiagramLegend(
@@ -1189,39 +1393,46 @@ void CppServiceHandler::getFileDiagram(
   const core::FileId& fileId_,
   const int32_t diagramId_)
 {
-  FileDiagram diagram(_db, _datadir, _context);
-  util::Graph graph;
-  graph.setAttribute("rankdir", "LR");
+  // The key is built from the numeric ID, so it is a valid file name.
+  const std::string key = "file-" + std::to_string(diagramId_) + '-'
+    + std::to_string(std::stoull(fileId_));
 
-  switch (diagramId_)
-  {
-    case COMPONENT_USERS:
-      diagram.getComponentUsersDiagram(graph, fileId_);
-      break;
+  return_ = _diagramCache->get(key, [&, this]{
+    FileDiagram diagram(_db, _datadir, _context);
+    util::Graph graph;
+    graph.setAttribute("rankdir", "LR");
 
-    case EXTERNAL_DEPENDENCY:
-      diagram.getExternalDependencyDiagram(graph, fileId_);
-      break;
+    switch (diagramId_)
+    {
+      case COMPONENT_USERS:
+        diagram.getComponentUsersDiagram(graph, fileId_);
+        break;
 
-    case EXTERNAL_USERS:
-      diagram.getExternalUsersDiagram(graph, fileId_);
-      break;
+      case EXTERNAL_DEPENDENCY:
+        diagram.getExternalDependencyDiagram(graph, fileId_);
+        break;
 
-    case INCLUDE_DEPENDENCY:
-      diagram.getIncludeDependencyDiagram(graph, fileId_);
-      break;
+      case EXTERNAL_USERS:
+        diagram.getExternalUsersDiagram(graph, fileId_);
+        break;
 
-    case INTERFACE:
-      diagram.getInterfaceDiagram(graph, fileId_);
-      break;
+      case INCLUDE_DEPENDENCY:
+        diagram.getIncludeDependencyDiagram(graph, fileId_);
+        break;
 
-    case SUBSYSTEM_DEPENDENCY:
-      diagram.getSubsystemDependencyDiagram(graph, fileId_);
-      break;
-  }
+      case INTERFACE:
+        diagram.getInterfaceDiagram(graph, fileId_);
+        break;
 
-  if (graph.nodeCount() != 0)
-    return_ = graph.output(util::Graph::SVG);
+      case SUBSYSTEM_DEPENDENCY:
+        diagram.getSubsystemDependencyDiagram(graph, fileId_);
+        break;
+    }
+
+    return graph.nodeCount() != 0
+      ? graph.output(util::Graph::SVG)
+      : std::string();
+  });
 }
 
 void CppServiceHandler::getFileDiagramLegend(
@@ -1272,6 +1483,78 @@ bool CppServiceHandler::compareByValue(
   return lhs.astValue < rhs.astValue;
 }
 
+bool CppServiceHandler::astReferenceQuery(
+  const std::int32_t referenceId_,
+  odb::query<model::CppAstNode>& query_)
+{
+  switch (referenceId_)
+  {
+    case DEFINITION:
+      query_ = AstQuery::astType == model::CppAstNode::AstType::Definition;
+      return true;
+
+    case DECLARATION:
+      query_ =
+        AstQuery::astType == model::CppAstNode::AstType::Declaration &&
+        AstQuery::visibleInSourceCode == true;
+      return true;
+
+    case USAGE:
+      query_ = AstQuery(true);
+      return true;
+
+    case CALLS_OF_THIS:
+      query_ = AstQuery::astType == model::CppAstNode::AstType::Usage;
+      return true;
+
+    case READ:
+      query_ = AstQuery::astType == model::CppAstNode::AstType::Read;
+      return true;
+
+    case WRITE:
+      query_ = AstQuery::astType == model::CppAstNode::AstType::Write;
+      return true;
+
+    case UNDEFINITION:
+      query_ = AstQuery::astType == model::CppAstNode::AstType::UnDefinition;
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+bool CppServiceHandler::queryReferenceCount(
+  std::uint64_t mangledNameHash_,
+  const std::int32_t referenceId_,
+  std::size_t& count_)
+{
+  std::size_t model::CppReferenceCount::* member;
+
+  switch (referenceId_)
+  {
+    case DEFINITION:    member = &model::CppReferenceCount::definition;   break;
+    case DECLARATION:   member = &model::CppReferenceCount::declaration;  break;
+    case USAGE:         member = &model::CppReferenceCount::usage;        break;
+    case CALLS_OF_THIS: member = &model::CppReferenceCount::callsOfThis;  break;
+    case CALLER:        member = &model::CppReferenceCount::caller;       break;
+    case READ:          member = &model::CppReferenceCount::read;         break;
+    case WRITE:         member = &model::CppReferenceCount::write;        break;
+    case UNDEFINITION:  member = &model::CppReferenceCount::undefinition; break;
+    case OVERRIDE:      member = &model::CppReferenceCount::overrides;    break;
+    case OVERRIDDEN_BY: member = &model::CppReferenceCount::overriddenBy; break;
+    default: return false;
+  }
+
+  model::CppReferenceCount count;
+
+  if (!_db->find(mangledNameHash_, count))
+    return false;
+
+  count_ = count.*member;
+  return true;
+}
+
 model::CppAstNode CppServiceHandler::queryCppAstNode(
   const core::AstNodeId& astNodeId_)
 {
@@ -1400,109 +1683,284 @@ CppServiceHandler::transitiveClosureOfRel(
   std::uint64_t to_,
   bool reverse_)
 {
-  std::unordered_set<std::uint64_t> ret;
-
-  std::queue<std::uint64_t> q;
-  q.push(to_);
-
-  while (!q.empty())
-  {
-    std::uint64_t current = q.front();
-    q.pop();
-
-    RelResult result = _db->query<model::CppRelation>(
-      (reverse_ ? RelQuery::lhs : RelQuery::rhs) == current &&
-      RelQuery::kind == kind_);
+  // The closure is computed by a single recursive query instead of querying
+  // the relations of the nodes one by one. UNION (instead of UNION ALL)
+  // removes the duplicates, so the recursion terminates on cycles too.
+  // The hashes are stored as signed 64-bit integers in the database.
+  const std::string from = reverse_ ? "\"lhs\"" : "\"rhs\"";
+  const std::string to = reverse_ ? "\"rhs\"" : "\"lhs\"";
+  const std::string kind = std::to_string(static_cast<int>(kind_));
+
+  const std::string sql
+    = "WITH RECURSIVE closure(node) AS ("
+      "SELECT " + to + " FROM \"CppRelation\""
+      " WHERE " + from + " = "
+      + std::to_string(static_cast<std::int64_t>(to_)) +
+      " AND \"kind\" = " + kind +
+      " UNION "
+      "SELECT r." + to + " FROM \"CppRelation\" r"
+      " JOIN closure ON r." + from + " = closure.node"
+      " WHERE r.\"kind\" = " + kind +
+      ") SELECT node FROM closure";
 
-    for (const model::CppRelation relation : result)
-    {
-      std::uint64_t otherSide = reverse_ ? relation.rhs : relation.lhs;
+  return _transaction([&, this](){
+    std::unordered_set<std::uint64_t> ret;
 
-      if (ret.find(otherSide) == ret.end())
-      {
-        ret.insert(otherSide);
-        q.push(otherSide);
-      }
-    }
-  }
+    for (const model::CppRelationClosure& row
+      : _db->query<model::CppRelationClosure>(sql))
+      ret.insert(row.node);
 
-  return ret;
+    return ret;
+  });
 }
 
 std::map<model::CppAstNodeId, std::vector<std::string>>
 CppServiceHandler::getTags(const std::vector<model::CppAstNode>& nodes_)
 {
+  typedef model::CppAstNode::SymbolType SymbolType;
+
   std::map<model::CppAstNodeId, std::vector<std::string>> tags;
 
+  // The tags of all nodes are collected by a constant number of queries: the
+  // diagrams and the reference lists may contain hundreds of nodes.
+  std::set<std::uint64_t> hashes;
   for (const model::CppAstNode& node : nodes_)
-  {
-    std::vector<cc::model::CppAstNode> defs
-      = queryDefinitions(std::to_string(node.id));
+    if (node.symbolType == SymbolType::Function ||
+        node.symbolType == SymbolType::Variable)
+      hashes.insert(node.mangledNameHash);
 
-    const model::CppAstNode& defNode = defs.empty() ? node : defs.front();
+  if (hashes.empty())
+    return tags;
 
-    switch (node.symbolType)
+  //--- Definitions of the nodes ---//
+
+  std::unordered_map<std::uint64_t, model::CppAstNode> defs;
+
+  for (const model::CppAstNode& def : queryDefinitions(hashes))
+    defs.emplace(def.mangledNameHash, def);
+
+  //--- Member types of the nodes and their definitions ---//
+
+  std::set<model::CppAstNodeId> memberIds;
+  for (const model::CppAstNode& node : nodes_)
+    if (hashes.count(node.mangledNameHash))
     {
-      case model::CppAstNode::SymbolType::Function:
-      {
-        for (const model::CppMemberType& mem : _db->query<model::CppMemberType>(
-          (MemTypeQuery::memberAstNode == defNode.id ||
-           MemTypeQuery::memberAstNode == node.id) &&
-          MemTypeQuery::kind == model::CppMemberType::Kind::Method))
-        {
-          //--- Visibility Tag---//
+      memberIds.insert(node.id);
 
-          std::string visibility
-            = cc::model::visibilityToString(mem.visibility);
+      auto it = defs.find(node.mangledNameHash);
+      if (it != defs.end())
+        memberIds.insert(it->second.id);
+    }
 
-          if (!visibility.empty())
-            tags[node.id].push_back(visibility);
-        }
+  std::map<model::CppAstNodeId, std::vector<model::CppMemberType>> members;
 
-        //--- Virtual Tag ---//
+  queryInChunks<model::CppMemberType>(
+    *_db, MemTypeQuery::memberAstNode, memberIds,
+    odb::query<model::CppMemberType>(true),
+    [&members](const model::CppMemberType& mem_) {
+      members[mem_.memberAstNode.object_id()].push_back(mem_);
+    });
 
-        FuncResult funcNodes = _db->query<cc::model::CppFunction>(
-          FuncQuery::mangledNameHash == defNode.mangledNameHash);
-        const model::CppFunction& funcNode = *funcNodes.begin();
+  //--- Functions and variables of the nodes ---//
 
-        for (const model::Tag& tag : funcNode.tags)
-          tags[node.id].push_back(model::tagToString(tag));
+  typedef std::unordered_map<std::uint64_t, std::vector<model::Tag>>
+    EntityTags;
 
-        break;
-      }
+  EntityTags funcTags;
+  EntityTags varTags;
 
-      case model::CppAstNode::SymbolType::Variable:
-      {
-        for (const model::CppMemberType& mem : _db->query<model::CppMemberType>(
-          (MemTypeQuery::memberAstNode == defNode.id ||
-           MemTypeQuery::memberAstNode == node.id) &&
-          MemTypeQuery::kind == model::CppMemberType::Kind::Field))
-        {
-          //--- Visibility Tag---//
+  queryInChunks<model::CppFunction>(
+    *_db, FuncQuery::mangledNameHash, hashes,
+    odb::query<model::CppFunction>(true),
+    [&funcTags](const model::CppFunction& func_) {
+      funcTags.emplace(
+        func_.mangledNameHash,
+        std::vector<model::Tag>(func_.tags.begin(), func_.tags.end()));
+    });
 
-          std::string visibility = model::visibilityToString(mem.visibility);
+  queryInChunks<model::CppVariable>(
+    *_db, VarQuery::mangledNameHash, hashes,
+    odb::query<model::CppVariable>(true),
+    [&varTags](const model::CppVariable& var_) {
+      varTags.emplace(
+        var_.mangledNameHash,
+        std::vector<model::Tag>(var_.tags.begin(), var_.tags.end()));
+    });
 
-          if (!visibility.empty())
-            tags[node.id].push_back(visibility);
-        }
+  //--- Tags ---//
 
-        //--- Global Tag ---//
+  for (const model::CppAstNode& node : nodes_)
+  {
+    if (!hashes.count(node.mangledNameHash))
+      continue;
 
-        VarResult varNodes = _db->query<cc::model::CppVariable>(
-          VarQuery::mangledNameHash == defNode.mangledNameHash);
-        const model::CppVariable& varNode = *varNodes.begin();
+    auto defIt = defs.find(node.mangledNameHash);
+    const model::CppAstNode& defNode
+      = defIt == defs.end() ? node : defIt->second;
 
-        for (const model::Tag& tag : varNode.tags)
-          tags[node.id].push_back(model::tagToString(tag));
+    const bool isFunction = node.symbolType == SymbolType::Function;
+    const model::CppMemberType::Kind kind = isFunction
+      ? model::CppMemberType::Kind::Method
+      : model::CppMemberType::Kind::Field;
 
-        break;
+    //--- Visibility Tag---//
+
+    std::vector<model::CppAstNodeId> ids{defNode.id};
+    if (node.id != defNode.id)
+      ids.push_back(node.id);
+
+    for (model::CppAstNodeId id : ids)
+      for (const model::CppMemberType& mem : members[id])
+      {
+        if (mem.kind != kind)
+          continue;
+
+        std::string visibility = model::visibilityToString(mem.visibility);
+
+        if (!visibility.empty())
+          tags[node.id].push_back(visibility);
       }
-    }
+
+    //--- Virtual and Global Tags ---//
+
+    const EntityTags& entityTags = isFunction ? funcTags : varTags;
+
+    auto tagIt = entityTags.find(defNode.mangledNameHash);
+    if (tagIt != entityTags.end())
+      for (const model::Tag& tag : tagIt->second)
+        tags[node.id].push_back(model::tagToString(tag));
   }
 
   return tags;
 }
 
+std::vector<model::CppAstNode> CppServiceHandler::queryDefinitions(
+  const std::set<std::uint64_t>& mangledNameHashes_)
+{
+  std::vector<model::CppAstNode> nodes;
+
+  queryInChunks<model::CppAstNode>(
+    *_db, AstQuery::mangledNameHash, mangledNameHashes_,
+    AstQuery::astType == model::CppAstNode::AstType::Definition &&
+    AstQuery::location.range.end.line != model::Position::npos,
+    [&nodes](const model::CppAstNode& node_) {
+      nodes.push_back(node_);
+    });
+
+  return nodes;
+}
+
+std::vector<model::CppAstNode> CppServiceHandler::queryMembers(
+  const model::CppAstNode& node_,
+  model::CppMemberType::Kind kind_)
+{
+  std::vector<model::CppAstNodeId> memberIds;
+
+  for (const model::CppMemberType& mem : _db->query<model::CppMemberType>(
+    MemTypeQuery::typeHash == node_.mangledNameHash &&
+    MemTypeQuery::kind == kind_))
+    // TODO: Filter by tags
+    memberIds.push_back(mem.memberAstNode.object_id());
+
+  // The members are loaded at once instead of loading them one by one
+  // through their lazy pointers.
+  std::vector<model::CppAstNode> nodes;
+
+  queryInChunks<model::CppAstNode>(
+    *_db, AstQuery::id, memberIds,
+    odb::query<model::CppAstNode>(true),
+    [&nodes](const model::CppAstNode& member_) {
+      nodes.push_back(member_);
+    });
+
+  return nodes;
+}
+
+std::map<core::AstNodeId, std::vector<AstNodeInfo>>
+CppServiceHandler::getTypeDefinitions(
+  const std::vector<AstNodeInfo>& variables_)
+{
+  std::map<core::AstNodeId, std::vector<AstNodeInfo>> result;
+
+  _transaction([&, this](){
+    std::set<std::uint64_t> varHashes;
+    for (const AstNodeInfo& variable : variables_)
+      varHashes.insert(variable.mangledNameHash);
+
+    //--- Types of the variables ---//
+
+    std::unordered_map<std::uint64_t, std::uint64_t> typeHashes;
+
+    queryInChunks<model::CppVariable>(
+      *_db, VarQuery::mangledNameHash, varHashes,
+      odb::query<model::CppVariable>(true),
+      [&typeHashes](const model::CppVariable& var_) {
+        typeHashes.emplace(var_.mangledNameHash, var_.typeHash);
+      });
+
+    std::set<std::uint64_t> candidateHashes;
+    for (const auto& typeHash : typeHashes)
+      candidateHashes.insert(typeHash.second);
+
+    std::set<std::uint64_t> types;
+
+    queryInChunks<model::CppType>(
+      *_db, TypeQuery::mangledNameHash, candidateHashes,
+      odb::query<model::CppType>(true),
+      [&types](const model::CppType& type_) {
+        types.insert(type_.mangledNameHash);
+      });
+
+    //--- Definitions of the types ---//
+
+    std::vector<model::CppAstNode> defs = queryDefinitions(types);
+    std::sort(defs.begin(), defs.end(), compareByValue);
+
+    std::unordered_map<std::uint64_t, std::vector<model::CppAstNode>>
+      defsByHash;
+    for (const model::CppAstNode& def : defs)
+      defsByHash[def.mangledNameHash].push_back(def);
+
+    CreateAstNodeInfo::TagMap tags = getTags(defs);
+    CreateAstNodeInfo createAstNodeInfo(tags);
+
+    for (const AstNodeInfo& variable : variables_)
+    {
+      auto typeIt = typeHashes.find(variable.mangledNameHash);
+      if (typeIt == typeHashes.end())
+        continue;
+
+      std::vector<AstNodeInfo>& typeDefs = result[variable.id];
+
+      for (const model::CppAstNode& def : defsByHash[typeIt->second])
+        typeDefs.push_back(createAstNodeInfo(def));
+    }
+  });
+
+  return result;
+}
+
+std::map<std::uint64_t, std::string> CppServiceHandler::getVariableTypes(
+  const std::vector<AstNodeInfo>& variables_)
+{
+  std::map<std::uint64_t, std::string> result;
+
+  std::set<std::uint64_t> hashes;
+  for (const AstNodeInfo& variable : variables_)
+    hashes.insert(variable.mangledNameHash);
+
+  _transaction([&, this](){
+    queryInChunks<model::CppVariable>(
+      *_db, VarQuery::mangledNameHash, hashes,
+      odb::query<model::CppVariable>(true),
+      [&result](const model::CppVariable& var_) {
+        result.emplace(var_.mangledNameHash, var_.qualifiedType);
+      });
+  });
+
+  return result;
+}
+
 std::size_t CppServiceHandler::queryCppAstNodeCount(
   const core::AstNodeId& astNodeId_,
   const AstQuery& query_)
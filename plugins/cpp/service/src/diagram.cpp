@@ -129,49 +129,64 @@ void Diagram::getClassCollaborationDiagram(
 
   //--- Get related types for the current and related types ---//
 
+  std::vector<std::pair<AstNodeInfo, AstNodeInfo>> dataMembers;
+  std::vector<AstNodeInfo> members;
+
   for (const AstNodeInfo& relatedNode : relatedNodes)
   {
-    std::vector<AstNodeInfo> dataMembers;
-    _cppHandler.getReferences(dataMembers, relatedNode.id,
+    nodes.clear();
+    _cppHandler.getReferences(nodes, relatedNode.id,
       CppServiceHandler::DATA_MEMBER, {});
 
-    for (const AstNodeInfo& node : dataMembers)
+    for (const AstNodeInfo& node : nodes)
     {
-      std::vector<AstNodeInfo> types;
-      _cppHandler.getReferences(types, node.id, CppServiceHandler::TYPE, {});
-
-      if (types.empty())
-        continue;
-
-      AstNodeInfo typeInfo = types.front();
-
-      util::Graph::Node typeNode;
-      auto it = visitedNodes.find(typeInfo.id);
-      if (it == visitedNodes.end())
-      {
-        typeNode = addNode(graph_, typeInfo);
-        decorateNode(graph_, typeNode, classNodeDecoration);
-        visitedNodes.insert(it, std::make_pair(typeInfo.id, typeNode));
-      }
-      else
-        typeNode = it->second;
-
-      GraphNodePair graphEdge(visitedNodes[relatedNode.id], typeNode);
-      auto edgeIt = visitedEdges.find(graphEdge);
-      if (edgeIt == visitedEdges.end())
-      {
-        util::Graph::Edge edge =
-          graph_.createEdge(visitedNodes[relatedNode.id], typeNode);
-        decorateEdge(graph_, edge, usedClassEdgeDecoration);
-        graph_.setEdgeAttribute(edge, "label", node.astNodeValue);
-        visitedEdges.insert(edgeIt, std::make_pair(graphEdge, edge));
-      }
-      else
-      {
-        std::string oldLabel = graph_.getEdgeAttribute(edgeIt->second, "label");
-        graph_.setEdgeAttribute(edgeIt->second, "label",
-          oldLabel + ", " + node.astNodeValue);
-      }
+      dataMembers.emplace_back(relatedNode, node);
+      members.push_back(node);
+    }
+  }
+
+  // The types of all data members are queried at once.
+  std::map<core::AstNodeId, std::vector<AstNodeInfo>> memberTypes
+    = _cppHandler.getTypeDefinitions(members);
+
+  for (const auto& dataMember : dataMembers)
+  {
+    const AstNodeInfo& relatedNode = dataMember.first;
+    const AstNodeInfo& node = dataMember.second;
+
+    const std::vector<AstNodeInfo>& types = memberTypes[node.id];
+
+    if (types.empty())
+      continue;
+
+    AstNodeInfo typeInfo = types.front();
+
+    util::Graph::Node typeNode;
+    auto it = visitedNodes.find(typeInfo.id);
+    if (it == visitedNodes.end())
+    {
+      typeNode = addNode(graph_, typeInfo);
+      decorateNode(graph_, typeNode, classNodeDecoration);
+      visitedNodes.insert(it, std::make_pair(typeInfo.id, typeNode));
+    }
+    else
+      typeNode = it->second;
+
+    GraphNodePair graphEdge(visitedNodes[relatedNode.id], typeNode);
+    auto edgeIt = visitedEdges.find(graphEdge);
+    if (edgeIt == visitedEdges.end())
+    {
+      util::Graph::Edge edge =
+        graph_.createEdge(visitedNodes[relatedNode.id], typeNode);
+      decorateEdge(graph_, edge, usedClassEdgeDecoration);
+      graph_.setEdgeAttribute(edge, "label", node.astNodeValue);
+      visitedEdges.insert(edgeIt, std::make_pair(graphEdge, edge));
+    }
+    else
+    {
+      std::string oldLabel = graph_.getEdgeAttribute(edgeIt->second, "label");
+      graph_.setEdgeAttribute(edgeIt->second, "label",
+        oldLabel + ", " + node.astNodeValue);
     }
   }
 }
@@ -329,11 +344,14 @@ std::string Diagram::getDetailedClassNodeLabel(const AstNodeInfo& nodeInfo_)
   _cppHandler.getReferences(nodes, nodeInfo_.id,
     CppServiceHandler::DATA_MEMBER, {});
 
+  std::map<std::uint64_t, std::string> types
+    = _cppHandler.getVariableTypes(nodes);
+
   for (auto it = nodes.begin(); it != nodes.end(); ++it)
   {
     std::string visibility = visibilityToHtml(*it);
     std::string content = memberContentToHtml(*it,
-      util::escapeHtml(it->astNodeValue + " : " + getProperty(it->id, "Type")));
+      util::escapeHtml(it->astNodeValue + " : " + types[it->mangledNameHash]));
 
     std::string attr = colAttr;
     if (it == nodes.end() - 1)
@@ -406,15 +424,6 @@ std::string Diagram::memberContentToHtml(
   return startTags + util::escapeHtml(content_) + endTags;
 }
 
-std::string Diagram::getProperty(
-  const core::AstNodeId& astNodeId_,
-  const std::string& property_)
-{
-  std::map<std::string, std::string> properties;
-  _cppHandler.getProperties(properties, astNodeId_);
-  return properties[property_];
-}
-
 util::Graph::Node Diagram::addNode(
   util::Graph& graph_,
   const AstNodeInfo& nodeInfo_)
@@ -492,7 +501,7 @@ util::Graph::Subgraph Diagram::addSubgraph(
   graph_.setSubgraphAttribute(subgraph, "id", fileInfo.id);
   graph_.setSubgraphAttribute(subgraph, "label", fileInfo.path);
 
-  _subgraphs.insert(it, std::make_pair(fileInfo.path, subgraph));
+  _subgraphs.insert(it, std::make_pair(fileId_, subgraph));
 
   return subgraph;
 }
@@ -102,13 +102,6 @@ private:
     const AstNodeInfo& node_,
     const std::string& content_);
 
-  /**
-   * This function returns the property of an AST node.
-   */
-  std::string getProperty(
-    const core::AstNodeId& astNodeId_,
-    const std::string& property_);
-
   /**
    * This function decorates a graph node.
    * @param graph_ A graph object.
@@ -0,0 +1,35 @@
+#include "diagramcache.h"
+
+namespace cc
+{
+namespace service
+{
+namespace language
+{
+
+DiagramCache::DiagramCache(
+  const std::string& dir_,
+  std::shared_ptr<webserver::ProjectGeneration> generation_)
+  : _dir(dir_, generation_)
+{
+}
+
+std::string DiagramCache::get(const std::string& key_, const Renderer& render_)
+{
+  const std::string name = key_ + ".svg";
+  std::string diagram;
+
+  if (_dir.read(name, diagram))
+    return diagram;
+
+  diagram = render_();
+
+  if (!diagram.empty())
+    _dir.write(name, diagram);
+
+  return diagram;
+}
+
+} // language
+} // service
+} // cc
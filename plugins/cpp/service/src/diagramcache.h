@@ -0,0 +1,49 @@
+#ifndef CC_SERVICE_LANGUAGE_DIAGRAMCACHE_H
+#define CC_SERVICE_LANGUAGE_DIAGRAMCACHE_H
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "generationdir.h"
+
+namespace cc
+{
+namespace service
+{
+namespace language
+{
+
+/**
+ * Rendered diagrams stored in the given directory.
+ *
+ * The layout of a large diagram takes much longer than collecting its nodes,
+ * so the rendered SVG is stored per diagram type and node. A diagram depends
+ * on the whole database, so the stored diagrams are valid until the project
+ * is parsed again, see GenerationDir.
+ */
+class DiagramCache
+{
+public:
+  typedef std::function<std::string()> Renderer;
+
+  DiagramCache(
+    const std::string& dir_,
+    std::shared_ptr<webserver::ProjectGeneration> generation_);
+
+  /**
+   * This function returns the stored diagram of the given key. If it is not
+   * stored yet then it is rendered by the given function. Empty diagrams are
+   * not stored.
+   */
+  std::string get(const std::string& key_, const Renderer& render_);
+
+private:
+  GenerationDir _dir;
+};
+
+} // language
+} // service
+} // cc
+
+#endif // CC_SERVICE_LANGUAGE_DIAGRAMCACHE_H
@@ -0,0 +1,105 @@
+#include <fstream>
+#include <iterator>
+
+#include <boost/filesystem.hpp>
+
+#include <util/logutil.h>
+
+#include "generationdir.h"
+
+namespace fs = boost::filesystem;
+
+namespace cc
+{
+namespace service
+{
+namespace language
+{
+
+GenerationDir::GenerationDir(
+  const std::string& dir_,
+  std::shared_ptr<webserver::ProjectGeneration> generation_)
+  : _dir(dir_),
+    _generation(generation_),
+    _current(0),
+    _cleaned(false)
+{
+}
+
+bool GenerationDir::read(const std::string& name_, std::string& content_)
+{
+  std::ifstream in((fs::path(currentDir()) / name_).string(), std::ios::binary);
+
+  if (!in)
+    return false;
+
+  content_.assign(
+    (std::istreambuf_iterator<char>(in)),
+    std::istreambuf_iterator<char>());
+
+  return true;
+}
+
+bool GenerationDir::write(const std::string& name_, const std::string& content_)
+{
+  const fs::path dir = currentDir();
+  const fs::path path = dir / name_;
+
+  boost::system::error_code ec;
+  fs::create_directories(dir, ec);
+
+  const fs::path tmpPath
+    = dir / fs::unique_path(name_ + "-%%%%%%%%.tmp", ec);
+
+  {
+    std::ofstream out(tmpPath.string(), std::ios::binary);
+    out.write(content_.data(), content_.size());
+
+    if (!out)
+    {
+      LOG(debug) << "Couldn't store file: " << path;
+      fs::remove(tmpPath, ec);
+      return false;
+    }
+  }
+
+  fs::rename(tmpPath, path, ec);
+  if (ec)
+  {
+    fs::remove(tmpPath, ec);
+    return false;
+  }
+
+  return true;
+}
+
+std::string GenerationDir::currentDir()
+{
+  std::time_t generation = _generation->get();
+  const std::string name = std::to_string(generation);
+
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  if (!_cleaned || generation != _current)
+  {
+    _current = generation;
+    _cleaned = true;
+
+    boost::system::error_code ec;
+    for (fs::directory_iterator it(_dir, ec), end; !ec && it != end;
+      it.increment(ec))
+      if (it->path().filename() != name)
+      {
+        LOG(debug) << "Removing outdated generation: " << it->path();
+
+        boost::system::error_code removeEc;
+        fs::remove_all(it->path(), removeEc);
+      }
+  }
+
+  return (fs::path(_dir) / name).string();
+}
+
+} // language
+} // service
+} // cc
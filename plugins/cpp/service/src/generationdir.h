@@ -0,0 +1,69 @@
+#ifndef CC_SERVICE_LANGUAGE_GENERATIONDIR_H
+#define CC_SERVICE_LANGUAGE_GENERATIONDIR_H
+
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <webserver/projectgeneration.h>
+
+namespace cc
+{
+namespace service
+{
+namespace language
+{
+
+/**
+ * Directory of stored results which are valid until the project is parsed
+ * again.
+ *
+ * The results of a generation (see webserver::ProjectGeneration) are stored in
+ * a subdirectory named after the generation, and the subdirectories of the
+ * earlier generations are removed.
+ */
+class GenerationDir
+{
+public:
+  GenerationDir(
+    const std::string& dir_,
+    std::shared_ptr<webserver::ProjectGeneration> generation_);
+
+  /**
+   * This function reads the file of the given name from the directory of the
+   * current generation.
+   * @return False if the file is not stored.
+   */
+  bool read(const std::string& name_, std::string& content_);
+
+  /**
+   * This function stores the content in the directory of the current
+   * generation under the given name. The file is written under a unique
+   * temporary name and then renamed, so concurrent readers of the same file
+   * never read a partial file.
+   * @return False if the file couldn't be written.
+   */
+  bool write(const std::string& name_, const std::string& content_);
+
+private:
+  /**
+   * This function returns the directory of the current generation and removes
+   * the directories of the earlier ones when the generation changes. The
+   * returned directory is not created.
+   */
+  std::string currentDir();
+
+  const std::string _dir;
+  std::shared_ptr<webserver::ProjectGeneration> _generation;
+
+  std::mutex _mutex;
+  std::time_t _current;
+  bool _cleaned;
+};
+
+} // language
+} // service
+} // cc
+
+#endif // CC_SERVICE_LANGUAGE_GENERATIONDIR_H
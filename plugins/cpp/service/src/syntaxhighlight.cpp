@@ -0,0 +1,229 @@
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+
+#include <util/logutil.h>
+
+#include "syntaxhighlight.h"
+
+namespace
+{
+
+/**
+ * Magic bytes and version of the stored format. The version has to be
+ * increased whenever the format or the token selection changes, so the stale
+ * files are recomputed.
+ */
+const char formatHeader[] = {'C', 'C', 'S', 'H', 1};
+
+void writeVarint(std::string& out_, std::uint64_t value_)
+{
+  while (value_ >= 0x80)
+  {
+    out_.push_back(static_cast<char>((value_ & 0x7f) | 0x80));
+    value_ >>= 7;
+  }
+
+  out_.push_back(static_cast<char>(value_));
+}
+
+bool readVarint(
+  const std::string& in_,
+  std::size_t& pos_,
+  std::uint64_t& value_)
+{
+  value_ = 0;
+
+  for (unsigned shift = 0; pos_ < in_.size() && shift < 64; shift += 7)
+  {
+    std::uint8_t byte = static_cast<std::uint8_t>(in_[pos_++]);
+    value_ |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+
+    if (!(byte & 0x80))
+      return true;
+  }
+
+  return false;
+}
+
+}
+
+namespace cc
+{
+namespace service
+{
+namespace language
+{
+
+SyntaxHighlightCache::SyntaxHighlightCache(
+  const std::string& dir_,
+  std::shared_ptr<webserver::ProjectGeneration> generation_)
+  : _dir(dir_, generation_)
+{
+}
+
+std::vector<SyntaxHighlightCache::Token> SyntaxHighlightCache::get(
+  const std::string& contentHash_,
+  const Builder& builder_)
+{
+  std::vector<Token> tokens;
+  std::string data;
+
+  if (_dir.read(contentHash_, data))
+  {
+    if (decode(data, tokens))
+      return tokens;
+
+    LOG(warning) << "Invalid syntax highlight file: " << contentHash_;
+    tokens.clear();
+  }
+
+  tokens = select(builder_());
+
+  // Files which haven't been parsed (yet) don't have AST nodes. Their empty
+  // highlight is not stored, so it is recomputed after they are parsed.
+  if (!tokens.empty())
+    _dir.write(contentHash_, encode(tokens));
+
+  return tokens;
+}
+
+const char* SyntaxHighlightCache::cssClass(
+  model::CppAstNode::SymbolType symbolType_)
+{
+  switch (symbolType_)
+  {
+    case model::CppAstNode::SymbolType::Variable: return "cm-variable-2";
+    case model::CppAstNode::SymbolType::Function: return "cm-def";
+    case model::CppAstNode::SymbolType::FunctionPtr: return "cm-variable-2";
+    case model::CppAstNode::SymbolType::Type: return "cm-variable-3";
+    case model::CppAstNode::SymbolType::Typedef: return "cm-variable-3";
+    case model::CppAstNode::SymbolType::Macro: return "cm-meta";
+    case model::CppAstNode::SymbolType::Enum: return "cm-variable-3";
+    case model::CppAstNode::SymbolType::EnumConstant: return "cm-atom";
+    case model::CppAstNode::SymbolType::Namespace: return "cm-qualifier";
+    case model::CppAstNode::SymbolType::StringLiteral: return "cm-string";
+    case model::CppAstNode::SymbolType::File: return "cm-string-2";
+    default: return nullptr;
+  }
+}
+
+std::string SyntaxHighlightCache::encode(const std::vector<Token>& tokens_)
+{
+  // Every token takes a few bytes: the line is stored relative to the
+  // previous token, the end line relative to the start line.
+  std::string data(std::begin(formatHeader), std::end(formatHeader));
+  data.reserve(data.size() + tokens_.size() * 5 + 8);
+
+  writeVarint(data, tokens_.size());
+
+  std::uint64_t prevLine = 0;
+
+  for (const Token& token : tokens_)
+  {
+    writeVarint(data, token.range.start.line - prevLine);
+    writeVarint(data, token.range.start.column);
+    writeVarint(data, token.range.end.line - token.range.start.line);
+    writeVarint(data, token.range.end.column);
+    writeVarint(data, static_cast<std::uint64_t>(token.symbolType));
+
+    prevLine = token.range.start.line;
+  }
+
+  return data;
+}
+
+bool SyntaxHighlightCache::decode(
+  const std::string& data_,
+  std::vector<Token>& tokens_)
+{
+  const std::size_t headerSize = sizeof(formatHeader);
+
+  if (data_.compare(0, headerSize, formatHeader, headerSize) != 0)
+    return false;
+
+  std::size_t pos = headerSize;
+  std::uint64_t size;
+
+  // A token takes at least five bytes, which bounds the allocation.
+  if (!readVarint(data_, pos, size) || size > data_.size() / 5)
+    return false;
+
+  tokens_.clear();
+  tokens_.reserve(size);
+
+  std::uint64_t line = 0;
+
+  for (std::uint64_t i = 0; i < size; ++i)
+  {
+    std::uint64_t lineDiff, column, endLineDiff, endColumn, symbolType;
+
+    if (!readVarint(data_, pos, lineDiff) ||
+        !readVarint(data_, pos, column) ||
+        !readVarint(data_, pos, endLineDiff) ||
+        !readVarint(data_, pos, endColumn) ||
+        !readVarint(data_, pos, symbolType))
+      return false;
+
+    line += lineDiff;
+
+    Token token;
+    token.range.start = model::Position(line, column);
+    token.range.end = model::Position(line + endLineDiff, endColumn);
+    token.symbolType
+      = static_cast<model::CppAstNode::SymbolType>(symbolType);
+
+    tokens_.push_back(token);
+  }
+
+  return pos == data_.size();
+}
+
+std::vector<SyntaxHighlightCache::Token> SyntaxHighlightCache::select(
+  std::vector<Token> candidates_)
+{
+  candidates_.erase(
+    std::remove_if(candidates_.begin(), candidates_.end(),
+      [](const Token& token_) {
+        const model::Range& range = token_.range;
+        return range.start.line == model::Position::npos ||
+          range.start.line != range.end.line ||
+          !(range.start < range.end) ||
+          !cssClass(token_.symbolType);
+      }),
+    candidates_.end());
+
+  // Containing ranges precede the ranges which start at the same position.
+  std::stable_sort(candidates_.begin(), candidates_.end(),
+    [](const Token& lhs_, const Token& rhs_) {
+      return lhs_.range.start < rhs_.range.start ||
+        (lhs_.range.start == rhs_.range.start &&
+         rhs_.range.end < lhs_.range.end);
+    });
+
+  std::vector<Token> tokens;
+  model::Position lastEnd(0, 0);
+
+  for (std::size_t i = 0; i < candidates_.size(); ++i)
+  {
+    const Token& token = candidates_[i];
+
+    // A candidate overlapping the next one contains it, or would be cut by
+    // it, so the next (inner) one is kept instead.
+    if (i + 1 < candidates_.size() &&
+        candidates_[i + 1].range.start < token.range.end)
+      continue;
+
+    if (token.range.start < lastEnd)
+      continue;
+
+    tokens.push_back(token);
+    lastEnd = token.range.end;
+  }
+
+  return tokens;
+}
+
+} // language
+} // service
+} // cc
@@ -0,0 +1,76 @@
+#ifndef CC_SERVICE_LANGUAGE_SYNTAXHIGHLIGHT_H
+#define CC_SERVICE_LANGUAGE_SYNTAXHIGHLIGHT_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <model/cppastnode.h>
+#include <model/position.h>
+
+#include "generationdir.h"
+
+namespace cc
+{
+namespace service
+{
+namespace language
+{
+
+/**
+ * Semantic highlighting of source files based on the symbol types of their
+ * AST nodes.
+ *
+ * The highlight of a file depends only on its content and the AST nodes of
+ * it, so it is computed once per content hash and stored in a compact binary
+ * form in the given directory until the project is parsed again, see
+ * GenerationDir. Files with the same content share the stored highlight.
+ */
+class SyntaxHighlightCache
+{
+public:
+  struct Token
+  {
+    model::Range range;
+    model::CppAstNode::SymbolType symbolType;
+  };
+
+  typedef std::function<std::vector<Token>()> Builder;
+
+  SyntaxHighlightCache(
+    const std::string& dir_,
+    std::shared_ptr<webserver::ProjectGeneration> generation_);
+
+  /**
+   * This function returns the highlighted tokens of a file with the given
+   * content hash in the order of their position. If these are not stored yet
+   * then they are selected from the candidates returned by the builder
+   * function. The selected tokens are single-line and don't overlap: of the
+   * nested candidates the innermost ones are kept.
+   */
+  std::vector<Token> get(
+    const std::string& contentHash_,
+    const Builder& builder_);
+
+  /**
+   * This function returns the CSS class of a symbol type, or nullptr if the
+   * symbol type is not highlighted. The class names are the ones of the
+   * CodeMirror editor used by the web GUI.
+   */
+  static const char* cssClass(model::CppAstNode::SymbolType symbolType_);
+
+  static std::string encode(const std::vector<Token>& tokens_);
+  static bool decode(const std::string& data_, std::vector<Token>& tokens_);
+
+private:
+  static std::vector<Token> select(std::vector<Token> candidates_);
+
+  GenerationDir _dir;
+};
+
+} // language
+} // service
+} // cc
+
+#endif // CC_SERVICE_LANGUAGE_SYNTAXHIGHLIGHT_H
@@ -0,0 +1,21 @@
+#ifndef CC_TEST_INDEXEDHEADER_H
+#define CC_TEST_INDEXEDHEADER_H
+
+// This header is included by two translation units. The one which is parsed
+// later skips the declarations of the header, since they have already been
+// indexed by the other one.
+
+class IndexedBase
+{
+public:
+  virtual ~IndexedBase() {}
+  virtual void method() {}
+};
+
+class ImplicitMembers
+{
+public:
+  int member;
+};
+
+#endif // CC_TEST_INDEXEDHEADER_H
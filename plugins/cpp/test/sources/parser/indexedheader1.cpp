@@ -0,0 +1,12 @@
+#include "indexedheader.h"
+
+class IndexedDerived1 : public IndexedBase
+{
+public:
+  void method() override {}
+};
+
+void setMember(ImplicitMembers& members_)
+{
+  members_.member = 0;
+}
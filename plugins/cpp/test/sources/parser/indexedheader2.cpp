@@ -0,0 +1,13 @@
+#include "indexedheader.h"
+
+class IndexedDerived2 : public IndexedBase
+{
+public:
+  void method() override {}
+};
+
+void assignMembers(ImplicitMembers& lhs_, const ImplicitMembers& rhs_)
+{
+  // The implicit copy assignment is declared only in this translation unit.
+  lhs_ = rhs_;
+}
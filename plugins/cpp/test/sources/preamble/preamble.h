@@ -0,0 +1,22 @@
+#ifndef CC_TEST_PREAMBLE_H
+#define CC_TEST_PREAMBLE_H
+
+// This header is included at the beginning of every translation unit of the
+// project, so they share a precompiled preamble.
+
+template <typename T>
+struct Holder
+{
+  T value;
+
+  T get() const { return value; }
+};
+
+class Shape
+{
+public:
+  virtual ~Shape() {}
+  virtual int area() const = 0;
+};
+
+#endif // CC_TEST_PREAMBLE_H
@@ -0,0 +1,16 @@
+#include "preamble.h"
+
+class Square : public Shape
+{
+public:
+  int area() const override { return _side * _side; }
+
+private:
+  int _side = 2;
+};
+
+int squareArea()
+{
+  Holder<Square> holder;
+  return holder.get().area();
+}
@@ -0,0 +1,17 @@
+#include "preamble.h"
+
+class Rectangle : public Shape
+{
+public:
+  int area() const override { return _width * _height; }
+
+private:
+  int _width = 2;
+  int _height = 3;
+};
+
+int rectangleArea()
+{
+  Holder<Rectangle> holder;
+  return holder.get().area();
+}
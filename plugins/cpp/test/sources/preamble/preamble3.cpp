@@ -0,0 +1,17 @@
+#include "preamble.h"
+
+class Triangle : public Shape
+{
+public:
+  int area() const override { return _base * _height / 2; }
+
+private:
+  int _base = 2;
+  int _height = 4;
+};
+
+int triangleArea(const Holder<int>& base_)
+{
+  Holder<Triangle> holder;
+  return holder.get().area() + base_.get();
+}
@@ -0,0 +1,105 @@
+#define GTEST_HAS_TR1_TUPLE 1
+#define GTEST_USE_OWN_TR1_TUPLE 0
+
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+
+#include <gtest/gtest.h>
+
+#include <model/cppastnode.h>
+#include <model/cppastnode-odb.hxx>
+
+#include <service/cppservice.h>
+
+#include <util/dbutil.h>
+
+#include "servicehelper.h"
+
+using namespace cc;
+using namespace cc::service::test;
+
+namespace fs = boost::filesystem;
+
+class CppAstNodeIndexServiceTest : public ::testing::Test
+{
+public:
+  CppAstNodeIndexServiceTest() :
+    _db(cc::util::connectDatabase(dbConnectionString)),
+    _transaction(_db),
+    _datadir(fs::temp_directory_path() / fs::unique_path()),
+    _cppservice(createService()),
+    _helper(_db, _cppservice)
+  {
+    _inheritanceClassHeader = _helper.getFileId("inheritance.h");
+  }
+
+  ~CppAstNodeIndexServiceTest()
+  {
+    boost::system::error_code ec;
+    fs::remove_all(_datadir, ec);
+  }
+
+  /**
+   * This function creates a service handler on the data directory of the
+   * test. The project_info.json file of the directory is created first, as
+   * the parser does.
+   */
+  std::shared_ptr<CppServiceHandler> createService()
+  {
+    fs::create_directories(_datadir);
+    std::ofstream((_datadir / "project_info.json").string()) << "{}";
+
+    return std::make_shared<CppServiceHandler>(
+      _db,
+      std::make_shared<std::string>(_datadir.string()),
+      cc::webserver::ServerContext(std::string(),
+                                   boost::program_options::variables_map()));
+  }
+
+protected:
+  std::shared_ptr<odb::database> _db;
+  cc::util::OdbTransaction _transaction;
+  fs::path _datadir;
+  std::shared_ptr<CppServiceHandler> _cppservice;
+  ServiceHelper _helper;
+
+  model::FileId _inheritanceClassHeader;
+};
+
+TEST_F(CppAstNodeIndexServiceTest, ReparsedIncluderTest)
+{
+  AstNodeInfo before
+    = _helper.getAstNodeInfoByPos(31, 13, _inheritanceClassHeader);
+  ASSERT_FALSE(before.id.empty());
+
+  // Reparsing a file which includes the unchanged header may add new nodes
+  // to the header, e.g. template instantiations. The new node is the
+  // innermost one at the position.
+  model::CppAstNode node = _transaction([&, this] {
+    return *_db->load<model::CppAstNode>(std::stoull(before.id));
+  });
+
+  node.astValue = "reparsed " + node.astValue;
+  node.location.range = model::Range(
+    model::Position(31, 13), model::Position(31, 14));
+  node.id = model::createIdentifier(node);
+
+  _transaction([&, this] { _db->persist(node); });
+
+  // The header hasn't changed, so the index is valid within the generation.
+  AstNodeInfo cached
+    = _helper.getAstNodeInfoByPos(31, 13, _inheritanceClassHeader);
+
+  // The parser rewrites the project_info.json file at the end of the run.
+  fs::path projectInfo = _datadir / "project_info.json";
+  fs::last_write_time(projectInfo, fs::last_write_time(projectInfo) + 10);
+
+  AstNodeInfo after
+    = _helper.getAstNodeInfoByPos(31, 13, _inheritanceClassHeader);
+
+  _transaction([&, this] { _db->erase<model::CppAstNode>(node.id); });
+
+  EXPECT_EQ(before.id, cached.id);
+  EXPECT_EQ(std::to_string(node.id), after.id);
+}
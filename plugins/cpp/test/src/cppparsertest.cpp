@@ -7,6 +7,8 @@
 #include <model/cppastnode-odb.hxx>
 #include <model/cppfunction.h>
 #include <model/cppfunction-odb.hxx>
+#include <model/cpprelation.h>
+#include <model/cpprelation-odb.hxx>
 #include <model/file.h>
 #include <model/file-odb.hxx>
 
@@ -18,6 +20,8 @@ extern const char* dbConnectionString;
 using namespace cc;
 
 using QCppAstNode = odb::query<model::CppAstNode>;
+using QCppFunction = odb::query<model::CppFunction>;
+using QCppRelation = odb::query<model::CppRelation>;
 using QFile = odb::query<model::File>;
 using RCppAstNode = odb::result<model::CppAstNode>;
 
@@ -615,3 +619,35 @@ TEST_F(CppParserTest, Namespace)
     }
   });
 }
+
+TEST_F(CppParserTest, IndexedHeaderOverride)
+{
+  _transaction([&, this] {
+    model::CppFunction base = _db->query_value<model::CppFunction>(
+      QCppFunction::qualifiedName == "IndexedBase::method");
+
+    // The overridden method has no AST node in the translation unit which
+    // skipped the header, but the relation has to be stored for both.
+    for (const std::string derivedName
+      : {"IndexedDerived1::method", "IndexedDerived2::method"})
+    {
+      model::CppFunction derived = _db->query_value<model::CppFunction>(
+        QCppFunction::qualifiedName == derivedName);
+
+      EXPECT_FALSE(_db->query<model::CppRelation>(
+        QCppRelation::kind == model::CppRelation::Kind::Override &&
+        QCppRelation::lhs == derived.mangledNameHash &&
+        QCppRelation::rhs == base.mangledNameHash).empty()) << derivedName;
+    }
+  });
+}
+
+TEST_F(CppParserTest, IndexedHeaderImplicitMembers)
+{
+  _transaction([&, this] {
+    // The implicit copy assignment is declared only in indexedheader2.cpp, so
+    // it has to be visited even if this translation unit skipped the header.
+    EXPECT_FALSE(_db->query<model::CppFunction>(
+      QCppFunction::qualifiedName == "ImplicitMembers::operator=").empty());
+  });
+}
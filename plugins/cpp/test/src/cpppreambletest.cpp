@@ -0,0 +1,96 @@
+#define GTEST_HAS_TR1_TUPLE 1
+#define GTEST_USE_OWN_TR1_TUPLE 0
+
+#include <map>
+#include <set>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <model/cppastnode.h>
+#include <model/cppastnode-odb.hxx>
+#include <model/file.h>
+#include <model/file-odb.hxx>
+
+#include <util/dbutil.h>
+#include <util/odbtransaction.h>
+
+extern const char* dbConnectionString;
+
+using namespace cc;
+
+namespace
+{
+
+/**
+ * This function returns the AST nodes of the given database in a comparable
+ * form, independently of their IDs.
+ */
+std::set<std::string> collectAstNodes(std::shared_ptr<odb::database> db_)
+{
+  util::OdbTransaction transaction(db_);
+
+  return transaction([&] {
+    std::map<model::FileId, std::string> paths;
+    for (const model::File& file : db_->query<model::File>())
+      paths[file.id] = file.path;
+
+    std::set<std::string> nodes;
+    for (const model::CppAstNode& node : db_->query<model::CppAstNode>())
+    {
+      const model::Range& range = node.location.range;
+
+      nodes.insert(
+        (node.location.file ? paths[node.location.file.object_id()] : "") +
+        ':' + std::to_string(range.start.line) +
+        ':' + std::to_string(range.start.column) +
+        ':' + std::to_string(range.end.line) +
+        ':' + std::to_string(range.end.column) +
+        ' ' + model::symbolTypeToString(node.symbolType) +
+        ' ' + model::astTypeToString(node.astType) +
+        ' ' + std::to_string(node.mangledNameHash) +
+        ' ' + node.astValue);
+    }
+
+    return nodes;
+  });
+}
+
+}
+
+class CppPreambleTest : public ::testing::Test
+{
+public:
+  CppPreambleTest() :
+    _db(cc::util::connectDatabase(dbConnectionString)),
+    // The same project is parsed without --reuse-preamble to this database,
+    // see plugins/cpp/test/CMakeLists.txt.
+    _referenceDb(cc::util::connectDatabase(util::updateConnectionString(
+      dbConnectionString,
+      "database",
+      util::connStrComponent(dbConnectionString, "database") + "_nopch")))
+  {
+  }
+
+protected:
+  std::shared_ptr<odb::database> _db;
+  std::shared_ptr<odb::database> _referenceDb;
+};
+
+TEST_F(CppPreambleTest, SameAstNodes)
+{
+  ASSERT_TRUE(_db);
+  ASSERT_TRUE(_referenceDb);
+
+  std::set<std::string> nodes = collectAstNodes(_db);
+  std::set<std::string> referenceNodes = collectAstNodes(_referenceDb);
+
+  EXPECT_FALSE(referenceNodes.empty());
+
+  for (const std::string& node : referenceNodes)
+    EXPECT_EQ(1u, nodes.count(node)) << "Missing with preamble: " << node;
+
+  for (const std::string& node : nodes)
+    EXPECT_EQ(1u, referenceNodes.count(node))
+      << "Extra with preamble: " << node;
+}
@@ -1,8 +1,15 @@
 #define GTEST_HAS_TR1_TUPLE 1
 #define GTEST_USE_OWN_TR1_TUPLE 0
 
+#include <algorithm>
+
 #include <gtest/gtest.h>
 
+#include <model/cppastnode.h>
+#include <model/cppastnode-odb.hxx>
+#include <model/cppreferencecount.h>
+#include <model/cppreferencecount-odb.hxx>
+
 #include <service/cppservice.h>
 
 #include <util/dbutil.h>
@@ -193,3 +200,108 @@ TEST_F(CppReferenceServiceTest, DerivedClassTest)
   _helper.checkReferences(8,  15, _inheritanceClassSrc, expected);
   _helper.checkReferences(50, 10, _inheritanceClassSrc, expected);
 }
+
+/******************************************************************************
+ *                           Stored reference counts
+ ******************************************************************************/
+
+TEST_F(CppReferenceServiceTest, StoredReferenceCountTest)
+{
+  // The reference counts of these kinds are computed by the parser, and the
+  // live count of them is the number of the listed references.
+  const std::vector<std::string> storedKinds = {
+    "Definition", "Declaration", "Usage", "Caller", "Reads", "Writes"};
+
+  for (model::FileId file : {_simpleClassSrc, _nestedClassSrc,
+                             _inheritanceClassSrc})
+  {
+    std::vector<model::CppAstNode> nodes = _transaction([&, this] {
+      auto result = _db->query<model::CppAstNode>(
+        odb::query<model::CppAstNode>::location.file == file &&
+        odb::query<model::CppAstNode>::location.range.end.line
+          != model::Position::npos);
+      return std::vector<model::CppAstNode>(result.begin(), result.end());
+    });
+
+    ASSERT_FALSE(nodes.empty());
+
+    for (const model::CppAstNode& node : nodes)
+    {
+      core::AstNodeId nodeId = std::to_string(node.id);
+
+      EXPECT_TRUE(_transaction([&, this] {
+        return _db->find<model::CppReferenceCount>(node.mangledNameHash)
+          != nullptr;
+      })) << "No stored reference count of " << node.astValue;
+
+      std::map<std::string, std::int32_t> kinds
+        = _helper.getReferenceType(nodeId);
+
+      for (const std::string& kind : storedKinds)
+      {
+        auto it = kinds.find(kind);
+        if (it == kinds.end())
+          continue;
+
+        std::vector<AstNodeInfo> references;
+        _cppservice->getReferences(references, nodeId, it->second, {});
+
+        EXPECT_EQ(
+          static_cast<std::int32_t>(references.size()),
+          _cppservice->getReferenceCount(nodeId, it->second))
+          << kind << " of " << node.astValue;
+      }
+    }
+  }
+}
+
+/******************************************************************************
+ *                              Reference pages
+ ******************************************************************************/
+
+TEST_F(CppReferenceServiceTest, ReferencesPageTest)
+{
+  AstNodeInfo derivedClass
+    = _helper.getAstNodeInfoByPos(31, 13, _inheritanceClassHeader);
+  std::int32_t usage = _helper.getReferenceType(derivedClass.id).at("Usage");
+
+  auto nodeIds = [](const std::vector<AstNodeInfo>& nodes_)
+  {
+    std::vector<core::AstNodeId> ids;
+    for (const AstNodeInfo& node : nodes_)
+      ids.push_back(node.id);
+    std::sort(ids.begin(), ids.end());
+    return ids;
+  };
+
+  std::vector<AstNodeInfo> references;
+  _cppservice->getReferences(references, derivedClass.id, usage, {});
+  ASSERT_EQ(5u, references.size());
+
+  // Pages requested in order continue from the cursor of the previous page.
+  std::vector<AstNodeInfo> seekPages;
+  for (std::int32_t pageNo = 0;; ++pageNo)
+  {
+    std::vector<AstNodeInfo> page;
+    _cppservice->getReferencesPage(page, derivedClass.id, usage, 2, pageNo);
+    if (page.empty())
+      break;
+
+    EXPECT_LE(page.size(), 2u);
+    seekPages.insert(seekPages.end(), page.begin(), page.end());
+  }
+
+  EXPECT_EQ(nodeIds(references), nodeIds(seekPages));
+
+  // Pages requested backwards have no cursor of their previous page so they
+  // are fetched by offset.
+  std::vector<AstNodeInfo> offsetPages;
+  for (std::int32_t pageNo = 1; pageNo >= 0; --pageNo)
+  {
+    std::vector<AstNodeInfo> page;
+    _cppservice->getReferencesPage(page, derivedClass.id, usage, 3, pageNo);
+    offsetPages.insert(offsetPages.begin(), page.begin(), page.end());
+  }
+
+  EXPECT_EQ(nodeIds(references), nodeIds(offsetPages));
+}
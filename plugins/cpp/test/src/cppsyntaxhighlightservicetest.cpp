@@ -0,0 +1,218 @@
+#define GTEST_HAS_TR1_TUPLE 1
+#define GTEST_USE_OWN_TR1_TUPLE 0
+
+#include <fstream>
+#include <set>
+#include <tuple>
+#include <utility>
+
+#include <boost/filesystem.hpp>
+
+#include <gtest/gtest.h>
+
+#include <model/cppastnode.h>
+#include <model/cppastnode-odb.hxx>
+
+#include <service/cppservice.h>
+
+#include <util/dbutil.h>
+
+#include "servicehelper.h"
+
+using namespace cc;
+using namespace cc::service::test;
+
+namespace fs = boost::filesystem;
+
+namespace
+{
+
+typedef std::tuple<std::size_t, std::size_t, std::size_t, std::size_t>
+  RangeTuple;
+
+RangeTuple toTuple(const model::Range& range_)
+{
+  return RangeTuple(
+    range_.start.line, range_.start.column,
+    range_.end.line, range_.end.column);
+}
+
+RangeTuple toTuple(const SyntaxHighlight& syntax_)
+{
+  return RangeTuple(
+    syntax_.range.startpos.line, syntax_.range.startpos.column,
+    syntax_.range.endpos.line, syntax_.range.endpos.column);
+}
+
+bool contains(const model::Range& outer_, const model::Range& inner_)
+{
+  return !(inner_.start < outer_.start) && !(outer_.end < inner_.end);
+}
+
+}
+
+class CppSyntaxHighlightServiceTest : public ::testing::Test
+{
+public:
+  CppSyntaxHighlightServiceTest() :
+    _db(cc::util::connectDatabase(dbConnectionString)),
+    _transaction(_db),
+    _datadir(fs::temp_directory_path() / fs::unique_path()),
+    _cppservice(createService()),
+    _helper(_db, _cppservice)
+  {
+    _inheritanceClassSrc = _helper.getFileId("inheritance.cpp");
+  }
+
+  ~CppSyntaxHighlightServiceTest()
+  {
+    boost::system::error_code ec;
+    fs::remove_all(_datadir, ec);
+  }
+
+  /**
+   * This function creates a service handler on the data directory of the
+   * test. The project_info.json file of the directory is created first, as
+   * the parser does.
+   */
+  std::shared_ptr<CppServiceHandler> createService()
+  {
+    fs::create_directories(_datadir);
+    std::ofstream((_datadir / "project_info.json").string()) << "{}";
+
+    return std::make_shared<CppServiceHandler>(
+      _db,
+      std::make_shared<std::string>(_datadir.string()),
+      cc::webserver::ServerContext(std::string(),
+                                   boost::program_options::variables_map()));
+  }
+
+  /**
+   * This function returns the directory of the stored highlights of the
+   * current generation.
+   */
+  fs::path generationDir()
+  {
+    return _datadir / "cppsyntaxhighlight" / std::to_string(
+      fs::last_write_time(_datadir / "project_info.json"));
+  }
+
+protected:
+  std::shared_ptr<odb::database> _db;
+  cc::util::OdbTransaction _transaction;
+  fs::path _datadir;
+  std::shared_ptr<CppServiceHandler> _cppservice;
+  ServiceHelper _helper;
+
+  model::FileId _inheritanceClassSrc;
+};
+
+TEST_F(CppSyntaxHighlightServiceTest, SelectionTest)
+{
+  std::vector<SyntaxHighlight> highlight;
+  _cppservice->getSyntaxHighlight(
+    highlight, std::to_string(_inheritanceClassSrc));
+
+  ASSERT_FALSE(highlight.empty());
+
+  // The tokens are single-line, ordered and don't overlap.
+  for (std::size_t i = 0; i < highlight.size(); ++i)
+  {
+    const SyntaxHighlight& syntax = highlight[i];
+
+    EXPECT_FALSE(syntax.className.empty());
+    EXPECT_EQ(syntax.range.startpos.line, syntax.range.endpos.line);
+    EXPECT_LT(syntax.range.startpos.column, syntax.range.endpos.column);
+
+    if (i > 0)
+      EXPECT_FALSE(
+        std::make_pair(syntax.range.startpos.line,
+                       syntax.range.startpos.column) <
+        std::make_pair(highlight[i - 1].range.endpos.line,
+                       highlight[i - 1].range.endpos.column));
+  }
+
+  // Of the nested single-line candidates the innermost ones are kept.
+  std::vector<model::Range> candidates = _transaction([this] {
+    typedef odb::query<model::CppAstNode> AstQuery;
+
+    std::vector<model::Range> ranges;
+    for (const model::CppAstNode& node : _db->query<model::CppAstNode>(
+      AstQuery::location.file == _inheritanceClassSrc &&
+      AstQuery::visibleInSourceCode == true &&
+      AstQuery::symbolType != model::CppAstNode::SymbolType::Other))
+    {
+      const model::Range& range = node.location.range;
+      if (range.start.line != model::Position::npos &&
+          range.start.line == range.end.line &&
+          range.start < range.end)
+        ranges.push_back(range);
+    }
+
+    return ranges;
+  });
+
+  std::set<RangeTuple> selected;
+  for (const SyntaxHighlight& syntax : highlight)
+    selected.insert(toTuple(syntax));
+
+  for (const model::Range& range : candidates)
+  {
+    bool innermost = true;
+    for (const model::Range& other : candidates)
+      if (toTuple(other) != toTuple(range) && contains(range, other))
+      {
+        innermost = false;
+        EXPECT_EQ(0u, selected.count(toTuple(range)));
+        break;
+      }
+
+    if (innermost)
+      EXPECT_EQ(1u, selected.count(toTuple(range)));
+  }
+}
+
+TEST_F(CppSyntaxHighlightServiceTest, StoredHighlightTest)
+{
+  std::vector<SyntaxHighlight> computed;
+  _cppservice->getSyntaxHighlight(
+    computed, std::to_string(_inheritanceClassSrc));
+
+  ASSERT_FALSE(computed.empty());
+  ASSERT_FALSE(fs::is_empty(generationDir()));
+
+  // The second request decodes the stored highlight.
+  std::vector<SyntaxHighlight> stored;
+  _cppservice->getSyntaxHighlight(
+    stored, std::to_string(_inheritanceClassSrc));
+
+  ASSERT_EQ(computed.size(), stored.size());
+
+  for (std::size_t i = 0; i < computed.size(); ++i)
+  {
+    EXPECT_EQ(toTuple(computed[i]), toTuple(stored[i]));
+    EXPECT_EQ(computed[i].className, stored[i].className);
+  }
+}
+
+TEST_F(CppSyntaxHighlightServiceTest, GenerationTest)
+{
+  std::vector<SyntaxHighlight> highlight;
+  _cppservice->getSyntaxHighlight(
+    highlight, std::to_string(_inheritanceClassSrc));
+
+  const fs::path oldDir = generationDir();
+  ASSERT_TRUE(fs::exists(oldDir));
+
+  // Reparsing rewrites the project_info.json file.
+  fs::path projectInfo = _datadir / "project_info.json";
+  fs::last_write_time(projectInfo, fs::last_write_time(projectInfo) + 10);
+
+  highlight.clear();
+  _cppservice->getSyntaxHighlight(
+    highlight, std::to_string(_inheritanceClassSrc));
+
+  EXPECT_FALSE(highlight.empty());
+  EXPECT_FALSE(fs::exists(oldDir));
+  EXPECT_TRUE(fs::exists(generationDir()));
+}
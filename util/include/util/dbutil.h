@@ -62,6 +62,30 @@ void removeTables(
   std::shared_ptr<odb::database> db_,
   const std::string& sqlDir_);
 
+/**
+ * This function merges the content of another CodeCompass database into the
+ * given one. Both databases have to be created from the same .sql files. The
+ * rows of the tables having hash-based IDs are stored only once. The rows of
+ * the tables having auto-generated IDs are renumbered: a row which equals to
+ * an existing one in all other columns is mapped to the existing row,
+ * otherwise it gets a new ID. The foreign keys referring these tables are
+ * updated accordingly.
+ *
+ * In SQLite the source database is attached to the target database. In
+ * PostgreSQL the source database is accessed through the postgres_fdw
+ * extension, so it has to be available on the target server.
+ *
+ * @param db_ Pointer to the ODB database which is the target of the merge.
+ * @param sourceConnStr_ Connection string of the source database.
+ * @param sqlDir_ Directory path of SQL files.
+ * @return True if the merge succeeded; otherwise, false. In case of failure
+ * the target database is not modified.
+ */
+bool mergeDatabase(
+  std::shared_ptr<odb::database> db_,
+  const std::string& sourceConnStr_,
+  const std::string& sqlDir_);
+
 /**
  * This function updates a value for a given key in the connection string. The
  * connection string has the following format: dbsystem:key1=value1;key2=value2.
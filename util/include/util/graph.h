@@ -203,7 +203,8 @@ public:
 
   /**
    * This function generates the string representation of the graph in the
-   * given format.
+   * given format. The graph is laid out by dot. Large graphs are laid out by
+   * the faster sfdp instead, so the layout time stays bounded.
    */
   std::string output(Format format_) const;
 
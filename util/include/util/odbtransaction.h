@@ -4,11 +4,16 @@
 #include <memory>
 #include <future>
 #include <cstring>
+#include <iterator>
+#include <string>
+#include <type_traits>
 
 #include <odb/database.hxx>
+#include <odb/exceptions.hxx>
 #include <odb/transaction.hxx>
 #include <odb/tracer.hxx>
 #include <odb/session.hxx>
+#include <odb/version.hxx>
 
 #include "logutil.h"
 
@@ -161,41 +166,141 @@ private:
   bool _switchCurrent;
 };
 
-template <typename Cont>
-void persistAll(Cont& cont_, std::shared_ptr<odb::database> db_)
+namespace internal
 {
-  for (typename Cont::value_type& item : cont_)
+  /**
+   * This trait tells whether ODB generated bulk persist statements for the
+   * given model type, i.e. the type was declared as
+   * `#pragma db object bulk(N)`. Bulk operations are supported by ODB only
+   * from version 2.5 and only for PostgreSQL among our database backends.
+   */
+  template <typename T, typename = void>
+  struct IsBulkPersistable : std::false_type {};
+
+#if defined(DATABASE_PGSQL) && ODB_VERSION >= 20470
+  template <typename T>
+  struct IsBulkPersistable<T, decltype(void(
+    odb::access::object_traits_impl<T, odb::id_pgsql>::batch))>
+    : std::integral_constant<bool,
+        (odb::access::object_traits_impl<T, odb::id_pgsql>::batch > 1)> {};
+#endif
+
+  /**
+   * This function persists the elements of the container one by one. This is
+   * the fallback strategy for the types which don't support bulk operations.
+   */
+  template <typename Cont>
+  void persistAll(
+    Cont& cont_,
+    std::shared_ptr<odb::database> db_,
+    std::false_type)
   {
-    try
+    for (typename Cont::value_type& item : cont_)
     {
-      db_->persist(*item);
+      try
+      {
+        db_->persist(*item);
+      }
+      catch (const odb::object_already_persistent& ex)
+      {
+        LOG(debug)
+          << item->toString();
+        LOG(warning)
+          << ex.what() << std::endl
+          << "Further changes in this transaction will be ignored!";
+      }
+      catch (const odb::database_exception& ex)
+      {
+        LOG(debug) << item->toString();
+
+#ifdef DATABASE_PGSQL
+        if (std::strstr(ex.what(), "25P02") != nullptr)
+        {
+          LOG(error) << "The transaction was aborted due to previous error, omitting further changes!";
+          break;
+        }
+#endif
+
+        LOG(error) << ex.what() << std::endl;
+        throw;
+      }
     }
-    catch (const odb::object_already_persistent& ex)
+  }
+
+  /**
+   * This function persists the elements of the container by ODB bulk
+   * operations. The objects are sent to the database in batches of the size
+   * given in the `bulk` pragma of the model type, so a translation unit with
+   * tens of thousands of AST nodes costs only a few round trips.
+   *
+   * A failing row (e.g. a duplicate) aborts the whole PostgreSQL transaction.
+   * Therefore the batch is persisted after a savepoint: if it fails then the
+   * transaction is rolled back to the savepoint and the objects are persisted
+   * one by one, with the same handling of the duplicates and the aborted
+   * transactions as for the other types.
+   */
+  template <typename Cont>
+  void persistAll(
+    Cont& cont_,
+    std::shared_ptr<odb::database> db_,
+    std::true_type)
+  {
+    const char* savepoint = "cc_bulk_persist";
+
+    try
     {
-      LOG(debug)
-        << item->toString();
-      LOG(warning)
-        << ex.what() << std::endl
-        << "Further changes in this transaction will be ignored!";
+      db_->execute(std::string("SAVEPOINT ") + savepoint);
     }
-    catch (const odb::database_exception& ex)
+    catch (const odb::database_exception&)
     {
-      LOG(debug) << item->toString();
+      // The transaction has already been aborted, which is reported by the
+      // object by object persistence.
+      persistAll(cont_, db_, std::false_type());
+      return;
+    }
 
-#ifdef DATABASE_PGSQL
-      if (std::strstr(ex.what(), "25P02") != nullptr)
+    try
+    {
+      db_->persist(cont_.begin(), cont_.end());
+      db_->execute(std::string("RELEASE SAVEPOINT ") + savepoint);
+    }
+    catch (const odb::multiple_exceptions& ex)
+    {
+      if (ex.fatal())
       {
-        LOG(error) << "The transaction was aborted due to previous error, omitting further changes!";
-        break;
+        LOG(error) << ex.what() << std::endl;
+        throw;
       }
-#endif
 
-      LOG(error) << ex.what() << std::endl;
-      throw;
+      LOG(debug)
+        << ex.failed() << " of " << ex.attempted()
+        << " objects could not be persisted in bulk, retrying one by one.";
+
+      db_->execute(std::string("ROLLBACK TO SAVEPOINT ") + savepoint);
+      db_->execute(std::string("RELEASE SAVEPOINT ") + savepoint);
+
+      persistAll(cont_, db_, std::false_type());
     }
   }
 }
 
+/**
+ * This function persists all elements of a container of object pointers in
+ * the current transaction. Model types declared with the `bulk` pragma are
+ * persisted in batches, the others object by object.
+ */
+template <typename Cont>
+void persistAll(Cont& cont_, std::shared_ptr<odb::database> db_)
+{
+  using Object = typename Cont::value_type::element_type;
+
+  if (cont_.empty())
+    return;
+
+  internal::persistAll(
+    cont_, db_, typename internal::IsBulkPersistable<Object>::type());
+}
+
 } // util
 } // cc
 
@@ -1,12 +1,15 @@
 #ifndef CC_UTIL_THREADPOOL_H
 #define CC_UTIL_THREADPOOL_H
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <thread>
+#include <vector>
 
 namespace cc
 {
@@ -36,6 +39,18 @@ public:
    */
   virtual void enqueue(JobData jobInfo) = 0;
 
+  /**
+   * @brief Enqueue a new job with the given priority. The workers prefer the
+   * jobs with higher priority to the ones with lower priority which are
+   * waiting in the pool at the same time.
+   *
+   * @warning Job execution might start immediately at enqueue's return!
+   *
+   * @param jobInfo   The job object to work on.
+   * @param priority  The priority of the job. Default priority is 0.
+   */
+  virtual void enqueue(JobData jobInfo, std::size_t priority) = 0;
+
   /**
    * @brief Notify all workers to exit after doing the remaining work
    * and wait for the threads to die.
@@ -78,6 +93,17 @@ public:
     _func(jobInfo_);
   }
 
+  /**
+   * @brief Execute the thread pool's function on the given job. The priority
+   * has no effect, since the job is run immediately.
+   *
+   * @param jobInfo  The job object to work on.
+   */
+  void enqueue(JobData jobInfo_, std::size_t)
+  {
+    _func(jobInfo_);
+  }
+
   /**
    * @brief Has no effect in single-threaded operation as enqueue()
    * automatically runs the job function.
@@ -93,11 +119,17 @@ private:
 };
 
 /**
- * @brief A simple thread pool which iterates a set of jobs dynamically.
+ * @brief A work-stealing thread pool which iterates a set of jobs dynamically.
  *
  * This class creates N worker threads in the background which are waken up
- * as jobs are added to the queue. Each worker takes a single job and executes
- * it, and the threads return to sleep.
+ * as jobs are added to the pool. Every worker has its own queue, and the
+ * enqueued jobs are distributed among these queues in a round-robin fashion.
+ * A worker takes the job with the highest priority from its own queue, and if
+ * that is empty, it steals the highest priority job from the queue of another
+ * worker. The number of pending jobs is kept in an atomic counter, so the
+ * workers don't contend on a single lock: the common lock is only taken for
+ * sleeping and waking up, and no worker sits idle while there is work left in
+ * the pool.
  *
  * @tparam JobData   Jobs are represented in a custom, user-defined structure.
  * @tparam Function  A user defined functor which the workers call to do the
@@ -111,16 +143,24 @@ public:
    * Create a new thread pool with the given number of threads and using the
    * given function as its work logic.
    *
-   * @param threadCount  The number of worker threads to create.
+   * @param threadCount  The number of worker threads to create. At least one
+   * worker is created.
    * @param func         The function to execute on the enqueued jobs.
    */
   PooledJobQueue(size_t threadCount_, Function func_)
-    : _threadCount(threadCount_), _die(false)
+    : _threadCount(std::max<size_t>(threadCount_, 1)),
+      _die(false),
+      _pending(0),
+      _sleeping(0),
+      _sequence(0)
   {
-    for (size_t i = 0; i < threadCount_; ++i)
+    for (size_t i = 0; i < _threadCount; ++i)
+      _queues.emplace_back(std::make_unique<WorkerQueue>());
+
+    for (size_t i = 0; i < _threadCount; ++i)
       _threads.emplace_back(std::thread(
         &PooledJobQueue<JobData, Function>::worker,
-        this, func_));
+        this, i, func_));
   }
 
   ~PooledJobQueue()
@@ -130,7 +170,8 @@ public:
   }
 
   /**
-   * @brief Enqueue a new job to be executed by the thread pool.
+   * @brief Enqueue a new job to be executed by the thread pool with default
+   * priority.
    *
    * @warning Job execution might start immediately at enqueue's return!
    *
@@ -138,9 +179,37 @@ public:
    */
   void enqueue(JobData jobInfo_)
   {
+    enqueue(jobInfo_, 0);
+  }
+
+  /**
+   * @brief Enqueue a new job to be executed by the thread pool.
+   *
+   * @warning Job execution might start immediately at enqueue's return!
+   *
+   * @param jobInfo   The job object to work on.
+   * @param priority  The priority of the job.
+   */
+  void enqueue(JobData jobInfo_, std::size_t priority_)
+  {
+    std::size_t sequence = _sequence++;
+    WorkerQueue& queue = *_queues[sequence % _threadCount];
+
+    // The counter is incremented before the job is published, so a worker
+    // taking the job can't decrement it first.
+    ++_pending;
+
     {
-      std::lock_guard<std::mutex> lock(_lock);
-      _queue.push(jobInfo_);
+      std::lock_guard<std::mutex> lock(queue.lock);
+      queue.jobs.push(Job{priority_, sequence, jobInfo_});
+    }
+
+    // A worker registers itself as sleeping before it checks the counter
+    // under the lock. Taking the lock here makes sure that such a worker
+    // either sees the new job or is already waiting for the notification.
+    if (_sleeping != 0)
+    {
+      std::lock_guard<std::mutex> lock(_sleepLock);
     }
 
     _signal.notify_one();
@@ -152,63 +221,109 @@ public:
    */
   void wait()
   {
-    _die = true;
+    {
+      std::lock_guard<std::mutex> lock(_sleepLock);
+      _die = true;
+    }
+
     _signal.notify_all();
 
     for (std::thread& t : _threads)
-    {
-      // Keep nudging the threads so that the t.join() don't grind the
-      // system to a halt.
-      _signal.notify_all();
       if (t.joinable())
         t.join();
-    }
   }
 
 private:
+  /**
+   * A job in the queue of a worker.
+   */
+  struct Job
+  {
+    std::size_t priority;
+
+    /**
+     * The order of enqueueing. Jobs with equal priority are executed in FIFO
+     * order.
+     */
+    std::size_t sequence;
+
+    JobData data;
+
+    bool operator<(const Job& other_) const
+    {
+      return priority != other_.priority
+        ? priority < other_.priority
+        : sequence > other_.sequence;
+    }
+  };
+
+  /**
+   * The job queue of a single worker guarded by its own mutex.
+   */
+  struct WorkerQueue
+  {
+    std::mutex lock;
+    std::priority_queue<Job> jobs;
+  };
+
+  /**
+   * @brief Take the highest priority job from the given queue and execute the
+   * function on it.
+   *
+   * @return True if a job has been done, false if the queue was empty.
+   */
+  bool tryRun(WorkerQueue& queue_, Function& function_)
+  {
+    std::unique_lock<std::mutex> lock(queue_.lock);
+
+    if (queue_.jobs.empty())
+      return false;
+
+    JobData job = queue_.jobs.top().data;
+    queue_.jobs.pop();
+
+    // After popping, we are out of the critical section.
+    lock.unlock();
+
+    --_pending;
+
+    // Do work.
+    function_(job);
+
+    return true;
+  }
+
   /**
    * @brief The worker method loops and waits for jobs to come and executes
-   * function on them.
+   * function on them. The worker takes jobs from its own queue first, and
+   * steals from the others' queues if its own queue is empty.
    */
-  void worker(Function function_)
+  void worker(std::size_t index_, Function function_)
   {
-    while (!(_die && _queue.empty()))  // The race condition here is known and
-                                       // allowed deliberately.
+    while (true)
     {
-      // Lock on the mutex so that the queue access is safe.
-      std::unique_lock<std::mutex> lock(_lock);
-      if (_queue.empty())
-      {
-        // If the queue is empty, we have to wait for new work to be enqueued.
-        // The thread is randomly woken up from time to time to ensure that
-        // work is being done, even if an enqueue() call could not notify
-        // any thread, because noone was waiting.
-        _signal.wait_for(lock, std::chrono::seconds(1), [this]()
-        {
-          return !_queue.empty();
-        });
-
-        // Signal hit: work has been given to us, lock is reacquired.
-        // Release the lock and notify other thread that we will be working.
-        lock.unlock();
-        _signal.notify_one();
-
-        continue; // Next cycle will take the work if noone snatches it from us.
-      }
-      else
+      bool worked = false;
+
+      for (std::size_t i = 0; i < _threadCount && !worked; ++i)
+        worked = tryRun(*_queues[(index_ + i) % _threadCount], function_);
+
+      if (worked)
+        continue;
+
+      std::unique_lock<std::mutex> lock(_sleepLock);
+
+      if (_die && _pending == 0)
+        break;
+
+      // If the queues are empty, we have to wait for new work to be
+      // enqueued. The thread is woken up from time to time to ensure that
+      // work is being done even if a notification was lost.
+      ++_sleeping;
+      _signal.wait_for(lock, std::chrono::seconds(1), [this]()
       {
-        // The queue was not empty, we can do actual work.
-        JobData job = _queue.front();
-        _queue.pop();
-
-        // After popping, we are out of the critical section.
-        // Give the lock back and signal another thread.
-        lock.unlock();
-        _signal.notify_one();
-
-        // Do work.
-        function_(job);
-      }
+        return _pending != 0 || _die;
+      });
+      --_sleeping;
     }
   }
 
@@ -218,9 +333,9 @@ private:
   const size_t _threadCount;
 
   /**
-   * std::mutex for accessing the _queue.
+   * std::mutex for the sleeping workers.
    */
-  std::mutex _lock;
+  std::mutex _sleepLock;
 
   /**
    * Condition variable to wake up worker threads.
@@ -234,10 +349,26 @@ private:
   std::atomic_bool _die;
 
   /**
-   * The queue contains the JobData objects which define the jobs the pool
-   * executes.
+   * The number of jobs which are enqueued but not taken by any worker yet.
+   */
+  std::atomic<std::size_t> _pending;
+
+  /**
+   * The number of workers which are waiting for new jobs.
+   */
+  std::atomic<std::size_t> _sleeping;
+
+  /**
+   * Counter of the enqueued jobs. It is used for distributing the jobs among
+   * the workers and for keeping FIFO order between equal priorities.
+   */
+  std::atomic<std::size_t> _sequence;
+
+  /**
+   * The queues of the workers contain the JobData objects which define the
+   * jobs the pool executes.
    */
-  std::queue<JobData> _queue;
+  std::vector<std::unique_ptr<WorkerQueue>> _queues;
 
   /**
    * Contains the worker threads.
@@ -1,5 +1,10 @@
+#include <algorithm>
 #include <fstream>
+#include <functional>
+#include <iterator>
 #include <map>
+#include <set>
+#include <string>
 #include <vector>
 
 #include <boost/algorithm/string.hpp>
@@ -17,6 +22,7 @@
 #endif
 
 #include <odb/connection.hxx>
+#include <odb/transaction.hxx>
 
 #include <util/logutil.h>
 #include <util/dbutil.h>
@@ -278,6 +284,459 @@ void runSqlFiles(
   }
 }
 
+/**
+ * Schema of a database table as described by the .sql files of ODB.
+ */
+struct TableSchema
+{
+  std::string name;
+  std::vector<std::string> columns;
+  bool autoId = false;
+
+  /**
+   * Foreign key columns mapped to the name of the referred table.
+   */
+  std::map<std::string, std::string> foreignKeys;
+};
+
+typedef std::map<std::string, TableSchema> Schema;
+
+/**
+ * The source database is available under this schema name during
+ * mergeDatabase().
+ */
+const std::string MERGE_SOURCE = "ccmerge";
+
+std::string quoteName(const std::string& name_)
+{
+  return '"' + name_ + '"';
+}
+
+std::string quoteLiteral(const std::string& value_)
+{
+  return '\'' + boost::replace_all_copy(value_, "'", "''") + '\'';
+}
+
+void addForeignKeys(TableSchema& table_, const std::string& sql_)
+{
+  static const boost::regex foreignKeyExpr(
+    "FOREIGN KEY \\(\"(\\w+)\"\\)\\s+REFERENCES \"(\\w+)\"");
+
+  for (boost::sregex_iterator it(sql_.begin(), sql_.end(), foreignKeyExpr), end;
+       it != end;
+       ++it)
+    table_.foreignKeys[(*it)[1].str()] = (*it)[2].str();
+}
+
+/**
+ * This function collects the tables, their columns and foreign keys from the
+ * .sql files which are produced by ODB. The regular expressions rely on the
+ * formatting of the ODB-generated SQL: every column definition is on its own
+ * line, indented by exactly two spaces, and the names are double quoted. If
+ * a table yields no columns (e.g. because this formatting has changed) then
+ * the function fails instead of copying nothing from it.
+ * @return False if no table or a table without columns was found.
+ */
+bool readSchema(const std::string& sqlDir_, Schema& schema_)
+{
+  static const boost::regex createTableExpr(
+    "CREATE TABLE (?:IF NOT EXISTS )?\"(\\w+)\" \\(([\\s\\S]*?)\\);");
+  static const boost::regex alterTableExpr(
+    "ALTER TABLE \"(\\w+)\"([\\s\\S]*?);");
+  static const boost::regex columnExpr("^  \"(\\w+)\" ([^\\n]*)$");
+
+  std::vector<std::string> contents;
+
+  for (
+    boost::filesystem::directory_iterator it(sqlDir_);
+    it != boost::filesystem::directory_iterator();
+    ++it)
+  {
+    if (!boost::filesystem::is_regular_file(it->path()))
+      continue;
+
+    std::ifstream file(it->path().native());
+
+    contents.emplace_back(
+      (std::istreambuf_iterator<char>(file)),
+      (std::istreambuf_iterator<char>()));
+  }
+
+  for (const std::string& content : contents)
+    for (boost::sregex_iterator it(
+           content.begin(), content.end(), createTableExpr), end;
+         it != end;
+         ++it)
+    {
+      TableSchema& table = schema_[(*it)[1].str()];
+      table.name = (*it)[1].str();
+
+      const std::string body = (*it)[2].str();
+
+      for (boost::sregex_iterator colIt(body.begin(), body.end(), columnExpr);
+           colIt != end;
+           ++colIt)
+      {
+        table.columns.push_back((*colIt)[1].str());
+
+        if ((*colIt)[1] == "id")
+        {
+          const std::string definition = (*colIt)[2].str();
+          table.autoId
+            = definition.find("AUTOINCREMENT") != std::string::npos
+           || definition.find("SERIAL") != std::string::npos;
+        }
+      }
+
+      addForeignKeys(table, body);
+    }
+
+  // In PostgreSQL the foreign keys are added after the table creation.
+  for (const std::string& content : contents)
+    for (boost::sregex_iterator it(
+           content.begin(), content.end(), alterTableExpr), end;
+         it != end;
+         ++it)
+    {
+      auto table = schema_.find((*it)[1].str());
+      if (table != schema_.end())
+        addForeignKeys(table->second, (*it)[2].str());
+    }
+
+  if (schema_.empty())
+  {
+    LOG(error) << "No table definition found in " << sqlDir_;
+    return false;
+  }
+
+  for (const auto& table : schema_)
+    if (table.second.columns.empty())
+    {
+      LOG(error)
+        << "No column definition found for table " << table.first
+        << " in " << sqlDir_ << ", the format of the SQL files is unknown.";
+      return false;
+    }
+
+  return true;
+}
+
+/**
+ * This function returns the name of the table with auto-generated IDs whose
+ * IDs are used by the given table. This is the table itself or, in case of
+ * polymorphic objects, the root table of the hierarchy. If the IDs of the
+ * table are not auto-generated then empty string returns.
+ */
+std::string idOwnerTable(const Schema& schema_, const std::string& table_)
+{
+  auto table = schema_.find(table_);
+
+  while (table != schema_.end() && !table->second.autoId)
+  {
+    auto foreignKey = table->second.foreignKeys.find("id");
+    if (foreignKey == table->second.foreignKeys.end()
+      || foreignKey->second == table->first)
+      return std::string();
+
+    table = schema_.find(foreignKey->second);
+  }
+
+  return table == schema_.end() ? std::string() : table->first;
+}
+
+/**
+ * This function returns the tables with auto-generated IDs in such an order
+ * that every table comes after the tables which it refers to.
+ */
+std::vector<const TableSchema*> autoIdTableOrder(const Schema& schema_)
+{
+  std::vector<const TableSchema*> order;
+  std::set<std::string> visited;
+
+  std::function<void(const TableSchema&)> visit
+    = [&](const TableSchema& table_)
+    {
+      if (!visited.insert(table_.name).second)
+        return;
+
+      for (const auto& foreignKey : table_.foreignKeys)
+      {
+        auto referred
+          = schema_.find(idOwnerTable(schema_, foreignKey.second));
+        if (referred != schema_.end())
+          visit(referred->second);
+      }
+
+      order.push_back(&table_);
+    };
+
+  for (const auto& table : schema_)
+    if (table.second.autoId)
+      visit(table.second);
+
+  return order;
+}
+
+std::string idMapTable(const std::string& table_)
+{
+  return quoteName(MERGE_SOURCE + "_map_" + table_);
+}
+
+std::string sourceTable(const std::string& table_)
+{
+  return MERGE_SOURCE + '.' + quoteName(table_);
+}
+
+/**
+ * This function returns the name of the table whose ID map translates the
+ * given column of the table. If the column needn't be translated then empty
+ * string returns.
+ */
+std::string referredIdTable(
+  const Schema& schema_,
+  const TableSchema& table_,
+  const std::string& column_)
+{
+  if (column_ == "id" && table_.autoId)
+    return table_.name;
+
+  auto foreignKey = table_.foreignKeys.find(column_);
+  return foreignKey == table_.foreignKeys.end()
+    ? std::string()
+    : idOwnerTable(schema_, foreignKey->second);
+}
+
+/**
+ * This function returns an SQL expression which gives the value of the column
+ * of the source row "s" as it has to be stored in the target database. The
+ * IDs of the tables with auto-generated IDs are translated by the ID map
+ * tables built by buildIdMap().
+ */
+std::string sourceValue(
+  const Schema& schema_,
+  const TableSchema& table_,
+  const std::string& column_)
+{
+  std::string referred = referredIdTable(schema_, table_, column_);
+
+  if (referred.empty())
+    return "s." + quoteName(column_);
+
+  return "(SELECT m.\"new\" FROM " + idMapTable(referred)
+    + " m WHERE m.\"old\" = s." + quoteName(column_) + ")";
+}
+
+/**
+ * This function builds a temporary table which maps the IDs of the source
+ * table to the IDs in the target database. If a source row equals to a target
+ * row in all columns except the ID then it is mapped to the ID of that row.
+ * Other rows get new IDs above the greatest ID of the target table. These
+ * are marked as fresh.
+ */
+void buildIdMap(
+  odb::connection& conn_,
+  const Schema& schema_,
+  const TableSchema& table_)
+{
+  const std::string idMap = idMapTable(table_.name);
+  const std::string source = sourceTable(table_.name);
+  const std::string target = quoteName(table_.name);
+
+  conn_.execute(
+    "CREATE TEMP TABLE " + idMap + " ("
+    "\"old\" BIGINT NOT NULL PRIMARY KEY, "
+    "\"new\" BIGINT NOT NULL, "
+    "\"fresh\" INTEGER NOT NULL)");
+
+  std::string columns;
+  std::string values;
+  std::string joins;
+  int joinCount = 0;
+
+  for (const std::string& column : table_.columns)
+  {
+    if (column == "id")
+      continue;
+
+    if (!columns.empty())
+    {
+      columns += ", ";
+      values += ", ";
+    }
+
+    columns += quoteName(column);
+
+    std::string referred = referredIdTable(schema_, table_, column);
+
+    if (referred.empty())
+      values += "s." + quoteName(column);
+    else
+    {
+      std::string alias = "m" + std::to_string(joinCount++);
+      values += alias + ".\"new\" AS " + quoteName(column);
+      joins += " LEFT JOIN " + idMapTable(referred) + ' ' + alias
+        + " ON " + alias + ".\"old\" = s." + quoteName(column);
+    }
+  }
+
+  if (!columns.empty())
+  {
+    // The foreign keys are translated once into a temporary table. This way
+    // the source and the target rows can be matched by a single partitioning
+    // instead of comparing every source row to every target row. Partitions,
+    // unlike the = operator, treat NULL values as equal.
+    const std::string remapped
+      = quoteName(MERGE_SOURCE + "_remap_" + table_.name);
+
+    conn_.execute(
+      "CREATE TEMP TABLE " + remapped + " AS SELECT s.\"id\" AS \"id\", "
+      + values + " FROM " + source + " s" + joins);
+
+    conn_.execute(
+      "INSERT INTO " + idMap +
+      " SELECT \"old\", \"new\", 0 FROM ("
+        "SELECT \"old\", MIN(\"target\") OVER (PARTITION BY " + columns
+        + ") AS \"new\" FROM ("
+          "SELECT CAST(NULL AS BIGINT) AS \"old\", \"id\" AS \"target\", "
+          + columns + " FROM " + target +
+          " UNION ALL "
+          "SELECT \"id\", CAST(NULL AS BIGINT), " + columns + " FROM "
+          + remapped + ") u) w"
+      " WHERE \"old\" IS NOT NULL AND \"new\" IS NOT NULL");
+
+    conn_.execute("DROP TABLE " + remapped);
+  }
+
+  conn_.execute(
+    "INSERT INTO " + idMap +
+    " SELECT s.\"id\", s.\"id\" + (SELECT COALESCE(MAX(\"id\"), 0) FROM "
+    + target + "), 1 FROM " + source + " s"
+    " WHERE s.\"id\" NOT IN (SELECT \"old\" FROM " + idMap + ")");
+}
+
+/**
+ * This function copies the rows of a source table to the target database.
+ * Rows of tables with hash-based IDs are skipped if the ID already exists.
+ * Rows of tables with auto-generated IDs are copied only if they are fresh.
+ * ODB container tables have no key: their rows are copied only if the target
+ * has no elements for the owner object yet.
+ */
+void copyRows(
+  odb::connection& conn_,
+  const Schema& schema_,
+  const TableSchema& table_)
+{
+  std::string columns;
+  std::string values;
+
+  for (const std::string& column : table_.columns)
+  {
+    if (!columns.empty())
+    {
+      columns += ", ";
+      values += ", ";
+    }
+
+    columns += quoteName(column);
+    values += sourceValue(schema_, table_, column);
+  }
+
+#ifdef DATABASE_SQLITE
+  std::string sql = "INSERT OR IGNORE INTO ";
+#else
+  std::string sql = "INSERT INTO ";
+#endif
+
+  sql += quoteName(table_.name) + " (" + columns + ") SELECT " + values
+    + " FROM " + sourceTable(table_.name) + " s";
+
+  bool hasId = std::find(table_.columns.begin(), table_.columns.end(), "id")
+    != table_.columns.end();
+  bool isContainer = !hasId
+    && std::find(table_.columns.begin(), table_.columns.end(), "object_id")
+    != table_.columns.end();
+
+  if (table_.autoId)
+    sql += " WHERE s.\"id\" IN (SELECT \"old\" FROM " + idMapTable(table_.name)
+      + " WHERE \"fresh\" = 1)";
+  else if (isContainer)
+    sql += " WHERE NOT EXISTS (SELECT 1 FROM " + quoteName(table_.name)
+      + " t WHERE t.\"object_id\" = "
+      + sourceValue(schema_, table_, "object_id") + ")";
+
+#ifdef DATABASE_PGSQL
+  sql += " ON CONFLICT DO NOTHING";
+#endif
+
+  conn_.execute(sql);
+}
+
+/**
+ * This function makes the source database of mergeDatabase() available under
+ * the MERGE_SOURCE schema name.
+ */
+void attachSource(odb::connection& conn_, const std::string& connStr_)
+{
+#ifdef DATABASE_SQLITE
+  std::string path = cc::util::connStrComponent(connStr_, "database");
+
+  if (path.substr(0, 2) == "~/")
+  {
+    if (char* home = std::getenv("HOME"))
+      path = home + path.substr(1);
+  }
+
+  conn_.execute(
+    "ATTACH DATABASE " + quoteLiteral(path) + " AS " + MERGE_SOURCE);
+#endif
+
+#ifdef DATABASE_PGSQL
+  auto options = [&connStr_](
+    const std::vector<std::pair<std::string, std::string>>& keys_)
+  {
+    std::string result;
+
+    for (const auto& key : keys_)
+    {
+      std::string value = cc::util::connStrComponent(connStr_, key.first);
+      if (value.empty())
+        continue;
+
+      result += (result.empty() ? " OPTIONS (" : ", ")
+        + key.second + ' ' + quoteLiteral(value);
+    }
+
+    return result.empty() ? result : result + ')';
+  };
+
+  conn_.execute("CREATE EXTENSION IF NOT EXISTS postgres_fdw");
+  conn_.execute("DROP SCHEMA IF EXISTS " + MERGE_SOURCE + " CASCADE");
+  conn_.execute("DROP SERVER IF EXISTS " + MERGE_SOURCE + " CASCADE");
+  conn_.execute(
+    "CREATE SERVER " + MERGE_SOURCE + " FOREIGN DATA WRAPPER postgres_fdw"
+    + options({{"host", "host"}, {"port", "port"}, {"database", "dbname"}}));
+  conn_.execute(
+    "CREATE USER MAPPING FOR CURRENT_USER SERVER " + MERGE_SOURCE
+    + options({{"user", "user"}, {"password", "password"}}));
+  conn_.execute("CREATE SCHEMA " + MERGE_SOURCE);
+  conn_.execute(
+    "IMPORT FOREIGN SCHEMA public FROM SERVER " + MERGE_SOURCE
+    + " INTO " + MERGE_SOURCE);
+#endif
+}
+
+void detachSource(odb::connection& conn_)
+{
+#ifdef DATABASE_SQLITE
+  conn_.execute("DETACH DATABASE " + MERGE_SOURCE);
+#endif
+
+#ifdef DATABASE_PGSQL
+  conn_.execute("DROP SCHEMA " + MERGE_SOURCE + " CASCADE");
+  conn_.execute("DROP SERVER " + MERGE_SOURCE + " CASCADE");
+#endif
+}
+
 }
 
 namespace cc
@@ -450,6 +909,78 @@ void createIndexes(
     "Creating indexes from file");
 }
 
+bool mergeDatabase(
+  std::shared_ptr<odb::database> db_,
+  const std::string& sourceConnStr_,
+  const std::string& sqlDir_)
+{
+  Schema schema;
+  if (!readSchema(sqlDir_, schema))
+    return false;
+
+  odb::connection_ptr connection = db_->connection();
+
+  try
+  {
+    attachSource(*connection, sourceConnStr_);
+  }
+  catch (const odb::exception& ex)
+  {
+    LOG(error)
+      << "Couldn't attach database " << sourceConnStr_ << ": " << ex.what();
+    return false;
+  }
+
+  bool success = true;
+
+  try
+  {
+    odb::transaction trans(connection->begin());
+
+    std::vector<const TableSchema*> autoIdTables = autoIdTableOrder(schema);
+
+    for (const TableSchema* table : autoIdTables)
+      buildIdMap(*connection, schema, *table);
+
+    for (const auto& table : schema)
+    {
+      LOG(debug) << "Merging table " << table.first;
+      copyRows(*connection, schema, table.second);
+    }
+
+    for (const TableSchema* table : autoIdTables)
+    {
+#ifdef DATABASE_PGSQL
+      // Explicitly inserted IDs don't advance the sequence of the column.
+      connection->execute(
+        "SELECT setval(pg_get_serial_sequence("
+        + quoteLiteral(quoteName(table->name)) + ", 'id'), "
+        "COALESCE(MAX(\"id\"), 0) + 1, false) FROM " + quoteName(table->name));
+#endif
+      connection->execute("DROP TABLE " + idMapTable(table->name));
+    }
+
+    trans.commit();
+  }
+  catch (const odb::exception& ex)
+  {
+    LOG(error)
+      << "Couldn't merge database " << sourceConnStr_ << ": " << ex.what();
+    success = false;
+  }
+
+  try
+  {
+    detachSource(*connection);
+  }
+  catch (const odb::exception& ex)
+  {
+    LOG(warning) << ex.what();
+  }
+
+  return success;
+}
+
 std::string updateConnectionString(
   std::string connStr_,
   const std::string& key_,
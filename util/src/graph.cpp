@@ -1,6 +1,43 @@
 #include <util/graph.h>
 #include "graphpimpl.h"
 
+namespace
+{
+
+/**
+ * Graphs with more nodes or edges than these limits are laid out by sfdp
+ * instead of dot. The hierarchical layout of dot is superlinear in the size of
+ * the graph: it takes minutes on the include graph of a central header, while
+ * the force-directed layout of sfdp scales to thousands of nodes.
+ */
+const int maxDotNodes = 300;
+const int maxDotEdges = 1000;
+
+/**
+ * Above this size the crossing minimization and the network simplex passes of
+ * dot are limited. The layout of such graphs is cluttered anyway, so the
+ * optimal placement is not worth its time.
+ */
+const int boundedDotNodes = 100;
+
+/**
+ * This function sets an attribute of the graph unless it is set by the user of
+ * the graph.
+ */
+void setDefault(Agraph_t* graph_, const char* key_, const char* value_)
+{
+  const char* value = agget(graph_, const_cast<char*>(key_));
+
+  if (!value || !*value)
+    agsafeset(
+      graph_,
+      const_cast<char*>(key_),
+      const_cast<char*>(value_),
+      const_cast<char*>(""));
+}
+
+}
+
 namespace cc
 {
 namespace util
@@ -267,7 +304,33 @@ std::string Graph::output(Graph::Format format_) const
   char** result        = new char*;
   unsigned int* length = new unsigned int;
 
-  gvLayout(_graphPimpl->_gvc, _graphPimpl->_graph, "dot");
+  Agraph_t* graph = _graphPimpl->_graph;
+  const int nodes = nodeCount();
+  const int edges = edgeCount();
+
+  if (nodes > maxDotNodes || edges > maxDotEdges)
+  {
+    setDefault(graph, "overlap", "false");
+    setDefault(graph, "splines", "line");
+
+    // sfdp is an optional plugin of Graphviz.
+    if (gvLayout(_graphPimpl->_gvc, graph, "sfdp") != 0)
+    {
+      LOG(warning) << "sfdp layout is not available, using dot.";
+      gvLayout(_graphPimpl->_gvc, graph, "dot");
+    }
+  }
+  else
+  {
+    if (nodes > boundedDotNodes)
+    {
+      setDefault(graph, "mclimit", "0.2");
+      setDefault(graph, "nslimit", "2");
+      setDefault(graph, "nslimit1", "2");
+    }
+
+    gvLayout(_graphPimpl->_gvc, graph, "dot");
+  }
 
   gvRenderData(
     _graphPimpl->_gvc,
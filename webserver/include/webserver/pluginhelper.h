@@ -1,7 +1,9 @@
 #ifndef CC_WEBSERVER_PLUGINHELPER_H
 #define CC_WEBSERVER_PLUGINHELPER_H
 
+#include <chrono>
 #include <memory>
+#include <set>
 
 #include <boost/filesystem.hpp>
 #include <boost/program_options/variables_map.hpp>
@@ -15,7 +17,9 @@
 #include <util/dbutil.h>
 #include <util/webserverutil.h>
 
+#include "projectgeneration.h"
 #include "requesthandler.h"
+#include "resultcache.h"
 #include "thrifthandler.h"
 
 namespace cc
@@ -94,6 +98,69 @@ inline void registerPluginSimple(
       "There are no parsed projects in the given workspace directory.");
 }
 
+/**
+ * Read-only functions of LanguageService. Their replies get entity tags and
+ * their results are cached.
+ */
+inline const std::set<std::string>& languageServiceCachedMethods()
+{
+  static const std::set<std::string> methods{
+    "getAstNodeInfo",
+    "getAstNodeInfoByPosition",
+    "getSourceText",
+    "getDocumentation",
+    "getProperties",
+    "getDiagramTypes",
+    "getDiagram",
+    "getDiagramLegend",
+    "getFileDiagramTypes",
+    "getFileDiagram",
+    "getFileDiagramLegend",
+    "getReferenceTypes",
+    "getReferenceCount",
+    "getReferences",
+    "getReferencesInFile",
+    "getReferencesPage",
+    "getFileReferenceTypes",
+    "getFileReferences",
+    "getFileReferenceCount",
+    "getSyntaxHighlight"};
+
+  return methods;
+}
+
+/**
+ * This function marks the given methods of a service handler read-only, and
+ * enables their result cache. The generation of the project, which changes
+ * when the project is parsed again, is part of the entity tags of the replies
+ * and the cache is cleared when it changes. The size of the cache is set by
+ * the result-cache-size option of the webserver.
+ */
+template <typename Processor>
+inline void enableResultCache(
+  ThriftHandler<Processor>& handler_,
+  const std::string& datadir_,
+  const ServerContext& ctx_,
+  const std::set<std::string>& methods_)
+{
+  handler_.setReadOnlyMethods(
+    std::make_shared<ProjectGeneration>(
+      datadir_ + "/project_info.json", std::chrono::seconds(1)),
+    methods_);
+
+  int size = ctx_.options.count("result-cache-size")
+    ? ctx_.options["result-cache-size"].as<int>()
+    : 0;
+
+  if (size <= 0)
+    return;
+
+  handler_.setResultCache(
+    std::make_shared<ResultCache>(
+      datadir_ + "/project_info.json",
+      static_cast<std::size_t>(size) * 1024 * 1024));
+}
+
 #define CODECOMPASS_SERVICE_FACTORY_WITH_CFG(serviceName, nspace) \
   [](std::shared_ptr<odb::database>& db_, \
      std::shared_ptr<std::string> datadir_, \
@@ -108,10 +175,14 @@ inline void registerPluginSimple(
   [](std::shared_ptr<odb::database>& db_, \
      std::shared_ptr<std::string> datadir_, \
      const cc::webserver::ServerContext& ctx_) { \
-    return new cc::webserver::ThriftHandler< \
+    auto handler = new cc::webserver::ThriftHandler< \
       cc::service::language::LanguageServiceProcessor>( \
         new cc::service::language::serviceName##ServiceHandler( \
           db_, datadir_, ctx_)); \
+    cc::webserver::enableResultCache( \
+      *handler, *datadir_, ctx_, \
+      cc::webserver::languageServiceCachedMethods()); \
+    return handler; \
   }
 
 } // webserver
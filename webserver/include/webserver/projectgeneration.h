@@ -0,0 +1,78 @@
+#ifndef CC_WEBSERVER_PROJECTGENERATION_H
+#define CC_WEBSERVER_PROJECTGENERATION_H
+
+#include <chrono>
+#include <ctime>
+#include <mutex>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+namespace cc
+{
+namespace webserver
+{
+
+/**
+ * Generation of the parsed data of a project.
+ *
+ * The parser rewrites the generation file (project_info.json) at the end of
+ * every run, so the modification time of this file identifies the content of
+ * the database. The stored service results are valid within one generation.
+ */
+class ProjectGeneration
+{
+public:
+  /**
+   * @param generationFile_ File which is rewritten when the database changes.
+   * @param checkInterval_ The file is checked at most once per this interval.
+   * By default it is checked at every call of get().
+   */
+  ProjectGeneration(
+    const std::string& generationFile_,
+    std::chrono::steady_clock::duration checkInterval_
+      = std::chrono::steady_clock::duration::zero())
+    : _generationFile(generationFile_),
+      _checkInterval(checkInterval_),
+      _generation(0),
+      _checked(false)
+  {
+  }
+
+  /**
+   * This function returns the current generation, i.e. the modification time
+   * of the generation file, or 0 if the file doesn't exist.
+   */
+  std::time_t get()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    const auto now = std::chrono::steady_clock::now();
+
+    if (_checked && now - _lastCheck < _checkInterval)
+      return _generation;
+
+    _checked = true;
+    _lastCheck = now;
+
+    boost::system::error_code ec;
+    std::time_t time = boost::filesystem::last_write_time(_generationFile, ec);
+    _generation = ec ? 0 : time;
+
+    return _generation;
+  }
+
+private:
+  const std::string _generationFile;
+  const std::chrono::steady_clock::duration _checkInterval;
+
+  std::mutex _mutex;
+  std::time_t _generation;
+  bool _checked;
+  std::chrono::steady_clock::time_point _lastCheck;
+};
+
+} // webserver
+} // cc
+
+#endif // CC_WEBSERVER_PROJECTGENERATION_H
@@ -18,8 +18,53 @@ namespace webserver
 class RequestHandler
 {
 public:
+  /**
+   * Reply of a request processed by processRequest().
+   */
+  struct Reply
+  {
+    std::string contentType;
+    std::string content;
+  };
+
   virtual std::string key() const = 0;
   virtual int beginRequest(struct mg_connection*) = 0;
+
+  /**
+   * Returns true if the requests of this handler can be processed by
+   * processRequest() instead of beginRequest().
+   */
+  virtual bool isAsync() const
+  {
+    return false;
+  }
+
+  /**
+   * Processes the content of a request with the given Content-Type header
+   * (empty if the request has none). Unlike beginRequest() this function
+   * doesn't access the connection, so it can run on a worker thread while the
+   * server thread keeps serving the other connections.
+   */
+  virtual void processRequest(
+    const std::string& /* contentType_ */,
+    const std::string& /* content_ */,
+    Reply&)
+  {
+  }
+
+  /**
+   * Returns the entity tag of the reply of the given request without
+   * processing it, or an empty string if the reply can't be identified in
+   * advance. Requests whose tag is listed in the If-None-Match header of the
+   * client are answered with 304 Not Modified instead of processRequest().
+   */
+  virtual std::string entityTag(
+    const std::string& /* contentType_ */,
+    const std::string& /* content_ */)
+  {
+    return std::string();
+  }
+
   virtual ~RequestHandler() {}
 };
 
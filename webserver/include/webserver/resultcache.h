@@ -0,0 +1,127 @@
+#ifndef CC_WEBSERVER_RESULTCACHE_H
+#define CC_WEBSERVER_RESULTCACHE_H
+
+#include <chrono>
+#include <ctime>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "projectgeneration.h"
+
+namespace cc
+{
+namespace webserver
+{
+
+/**
+ * Size-bounded LRU cache of serialized service results.
+ *
+ * The results are valid until the project is parsed again, so the cache is
+ * cleared when the generation of the project changes (see ProjectGeneration).
+ */
+class ResultCache
+{
+public:
+  /**
+   * @param generationFile_ File which is rewritten when the database changes.
+   * @param capacity_ Maximal total size of the cached keys and values in
+   * bytes.
+   */
+  ResultCache(const std::string& generationFile_, std::size_t capacity_)
+    : _capacity(capacity_),
+      _size(0),
+      // The generation file is checked at most once per second.
+      _projectGeneration(generationFile_, std::chrono::seconds(1)),
+      _generation(_projectGeneration.get())
+  {
+  }
+
+  /**
+   * This function looks up the value of the given key. On success the value
+   * is copied to value_ and the entry becomes the most recently used one.
+   */
+  bool get(const std::string& key_, std::string& value_)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    checkGeneration();
+
+    auto it = _index.find(key_);
+    if (it == _index.end())
+      return false;
+
+    _entries.splice(_entries.begin(), _entries, it->second);
+    value_ = it->second->second;
+
+    return true;
+  }
+
+  /**
+   * This function stores a value and evicts the least recently used entries
+   * if the cache exceeds its capacity. Values larger than the capacity are
+   * not stored.
+   */
+  void put(const std::string& key_, const std::string& value_)
+  {
+    const std::size_t size = key_.size() + value_.size();
+
+    if (size > _capacity)
+      return;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    checkGeneration();
+
+    auto it = _index.find(key_);
+    if (it != _index.end())
+      erase(it);
+
+    _entries.emplace_front(key_, value_);
+    _index.emplace(key_, _entries.begin());
+    _size += size;
+
+    while (_size > _capacity)
+      erase(_index.find(_entries.back().first));
+  }
+
+private:
+  typedef std::list<std::pair<std::string, std::string>> EntryList;
+  typedef std::unordered_map<std::string, EntryList::iterator> Index;
+
+  void checkGeneration()
+  {
+    std::time_t generation = _projectGeneration.get();
+    if (generation == _generation)
+      return;
+
+    _generation = generation;
+    _entries.clear();
+    _index.clear();
+    _size = 0;
+  }
+
+  void erase(Index::iterator it_)
+  {
+    _size -= it_->first.size() + it_->second->second.size();
+    _entries.erase(it_->second);
+    _index.erase(it_);
+  }
+
+  const std::size_t _capacity;
+
+  std::mutex _mutex;
+  EntryList _entries;
+  Index _index;
+  std::size_t _size;
+
+  ProjectGeneration _projectGeneration;
+  std::time_t _generation;
+};
+
+} // webserver
+} // cc
+
+#endif // CC_WEBSERVER_RESULTCACHE_H
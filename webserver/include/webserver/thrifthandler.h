@@ -2,16 +2,25 @@
 #define CC_WEBSERVER_THRIFTHANDLER_H
 
 #include <stdio.h>
+#include <strings.h>
+#include <cstring>
+#include <ctime>
 #include <memory>
+#include <set>
 
 #include <thrift/transport/TBufferTransports.h>
 #include <thrift/transport/THttpServer.h>
 #include <thrift/transport/TTransport.h>
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/protocol/TCompactProtocol.h>
 #include <thrift/protocol/TJSONProtocol.h>
 
+#include <util/hash.h>
 #include <util/logutil.h>
 
 #include "mongoose.h"
+#include "projectgeneration.h"
+#include "resultcache.h"
 
 /**
  * Returns the demangled name of the type described by the given type info.
@@ -105,40 +114,41 @@ public:
     return "ThriftHandler";
   }
 
-  int beginRequest(struct mg_connection *conn_) override
+  /**
+   * Marks the given methods read-only: their result may depend only on their
+   * arguments and on the database of the project, whose parses are counted by
+   * the given generation. The replies of these methods get entity tags, and
+   * they can be cached by setResultCache().
+   */
+  void setReadOnlyMethods(
+    std::shared_ptr<ProjectGeneration> generation_,
+    std::set<std::string> methods_)
   {
-    using namespace ::apache::thrift;
-    using namespace ::apache::thrift::transport;
-    using namespace ::apache::thrift::protocol;
+    _generation = std::move(generation_);
+    _readOnlyMethods = std::move(methods_);
+  }
 
+  /**
+   * Enables caching the results of the read-only methods.
+   */
+  void setResultCache(std::shared_ptr<ResultCache> cache_)
+  {
+    _resultCache = std::move(cache_);
+  }
+
+  int beginRequest(struct mg_connection *conn_) override
+  {
     try
     {
-      std::string content = getContent(conn_);
-
-      LOG(debug) << "Request content:\n" << content;
+      const Protocol protocol
+        = getProtocol(mg_get_header(conn_, "Content-Type"));
 
-      std::shared_ptr<TTransport> inputBuffer(
-        new TMemoryBuffer((std::uint8_t*)content.c_str(), content.length()));
-
-      std::shared_ptr<TTransport> outputBuffer(new TMemoryBuffer(4096));
-
-      std::shared_ptr<TProtocol> inputProtocol(
-        new TJSONProtocol(inputBuffer));
-      std::shared_ptr<TProtocol> outputProtocol(
-        new TJSONProtocol(outputBuffer));
-
-      CallContext ctx{conn_, nullptr};
-      _processor.process(inputProtocol, outputProtocol, &ctx);
-
-      TMemoryBuffer *mBuffer = dynamic_cast<TMemoryBuffer*>(outputBuffer.get());
-
-      std::string response = mBuffer->getBufferAsString();
-
-      LOG(debug)
-        << "Response:\n" << response.c_str() << std::endl;
+      // The request is read directly from the buffer of the connection.
+      std::string response = process(
+        protocol, conn_->content, conn_->content_len, conn_);
 
       // Send HTTP reply to the client create headers
-      mg_send_header(conn_, "Content-Type", "application/x-thrift");
+      mg_send_header(conn_, "Content-Type", getContentType(protocol));
       mg_send_header(
         conn_, "Content-Length", std::to_string(response.length()).c_str());
 
@@ -162,13 +172,248 @@ public:
     return MG_TRUE;
   }
 
+  bool isAsync() const override
+  {
+    return true;
+  }
+
+  void processRequest(
+    const std::string& contentType_,
+    const std::string& content_,
+    Reply& reply_) override
+  {
+    const Protocol protocol = getProtocol(contentType_.c_str());
+
+    reply_.contentType = getContentType(protocol);
+    reply_.content = process(
+      protocol, content_.data(), content_.size(), nullptr);
+  }
+
+  /**
+   * The tag of a read-only call consists of the generation of the project and
+   * the cache key of the call, so it doesn't depend on the sequence number.
+   */
+  std::string entityTag(
+    const std::string& contentType_,
+    const std::string& content_) override
+  {
+    if (!_generation)
+      return std::string();
+
+    std::string key;
+    std::string methodName;
+    std::int32_t seqid;
+
+    if (!getCacheKey(getProtocol(contentType_.c_str()),
+      content_.data(), content_.size(), methodName, seqid, key))
+      return std::string();
+
+    // Without project_info.json the parses of the project can't be told
+    // apart.
+    const std::time_t generation = _generation->get();
+    if (generation == 0)
+      return std::string();
+
+    return "W/\"" + util::sha1Hash(std::to_string(generation) + ':' + key)
+      + '"';
+  }
+
 private:
-  std::string getContent(mg_connection* conn_)
+  /**
+   * Thrift protocols which can be used by the clients. The protocol of a
+   * request is selected by its Content-Type header. The binary protocols are
+   * much cheaper to encode and decode than JSON, which is used by the web GUI.
+   */
+  enum class Protocol
+  {
+    JSON,
+    Binary,
+    Compact
+  };
+
+  static Protocol getProtocol(const char* contentType_)
+  {
+    if (!contentType_)
+      return Protocol::JSON;
+
+    // Parameters of the media type (e.g. charset) are ignored.
+    const std::size_t length = std::strcspn(contentType_, "; ");
+
+    auto is = [&](const char* type_) {
+      return length == std::strlen(type_) &&
+        strncasecmp(contentType_, type_, length) == 0;
+    };
+
+    if (is("application/vnd.apache.thrift.binary"))
+      return Protocol::Binary;
+    if (is("application/vnd.apache.thrift.compact"))
+      return Protocol::Compact;
+
+    // application/x-thrift and application/vnd.apache.thrift.json
+    return Protocol::JSON;
+  }
+
+  static const char* getContentType(Protocol protocol_)
   {
-    return std::string(conn_->content, conn_->content + conn_->content_len);
+    switch (protocol_)
+    {
+      case Protocol::Binary: return "application/vnd.apache.thrift.binary";
+      case Protocol::Compact: return "application/vnd.apache.thrift.compact";
+      default: return "application/x-thrift";
+    }
+  }
+
+  static std::shared_ptr<apache::thrift::protocol::TProtocol> createProtocol(
+    Protocol protocol_,
+    std::shared_ptr<apache::thrift::transport::TTransport> transport_)
+  {
+    using namespace ::apache::thrift::protocol;
+
+    switch (protocol_)
+    {
+      case Protocol::Binary:
+        return std::make_shared<TBinaryProtocol>(transport_);
+      case Protocol::Compact:
+        return std::make_shared<TCompactProtocol>(transport_);
+      default:
+        return std::make_shared<TJSONProtocol>(transport_);
+    }
+  }
+
+  /**
+   * This function processes a Thrift call and returns the serialized result.
+   * The request is not copied: the input transport observes the given buffer.
+   */
+  std::string process(
+    Protocol protocol_,
+    const char* content_,
+    std::size_t length_,
+    mg_connection* conn_)
+  {
+    using namespace ::apache::thrift;
+    using namespace ::apache::thrift::transport;
+    using namespace ::apache::thrift::protocol;
+
+    if (protocol_ == Protocol::JSON)
+      LOG(debug) << "Request content:\n" << std::string(content_, length_);
+
+    std::string cacheKey;
+    std::string methodName;
+    std::int32_t seqid;
+
+    if (_resultCache && getCacheKey(
+      protocol_, content_, length_, methodName, seqid, cacheKey))
+    {
+      std::string result;
+      if (_resultCache->get(cacheKey, result))
+        return messageHeader(protocol_, methodName, seqid) + result;
+    }
+
+    std::shared_ptr<TTransport> inputBuffer(new TMemoryBuffer(
+      reinterpret_cast<std::uint8_t*>(const_cast<char*>(content_)),
+      length_,
+      TMemoryBuffer::OBSERVE));
+
+    std::shared_ptr<TTransport> outputBuffer(new TMemoryBuffer(4096));
+
+    std::shared_ptr<TProtocol> inputProtocol
+      = createProtocol(protocol_, inputBuffer);
+    std::shared_ptr<TProtocol> outputProtocol
+      = createProtocol(protocol_, outputBuffer);
+
+    CallContext ctx{conn_, nullptr};
+    _processor.process(inputProtocol, outputProtocol, &ctx);
+
+    TMemoryBuffer *mBuffer = dynamic_cast<TMemoryBuffer*>(outputBuffer.get());
+
+    std::string response = mBuffer->getBufferAsString();
+
+    if (protocol_ == Protocol::JSON)
+      LOG(debug) << "Response:\n" << response.c_str() << std::endl;
+
+    // Only the part after the message header is cached, because the header
+    // contains the sequence number of the call. Exceptions thrown by the
+    // processor have a different message type, so they are not cached.
+    if (!cacheKey.empty())
+    {
+      const std::string header = messageHeader(protocol_, methodName, seqid);
+
+      if (response.compare(0, header.size(), header) == 0)
+        _resultCache->put(cacheKey, response.substr(header.size()));
+    }
+
+    return response;
+  }
+
+  /**
+   * This function reads the message header of a call. If the called method
+   * is read-only then it returns true and the cache key which consists of the
+   * protocol, the method name and the serialized arguments.
+   */
+  bool getCacheKey(
+    Protocol protocol_,
+    const char* content_,
+    std::size_t length_,
+    std::string& methodName_,
+    std::int32_t& seqid_,
+    std::string& key_) const
+  {
+    using namespace ::apache::thrift;
+    using namespace ::apache::thrift::transport;
+    using namespace ::apache::thrift::protocol;
+
+    std::shared_ptr<TMemoryBuffer> buffer(new TMemoryBuffer(
+      reinterpret_cast<std::uint8_t*>(const_cast<char*>(content_)),
+      length_,
+      TMemoryBuffer::OBSERVE));
+
+    TMessageType type;
+
+    try
+    {
+      createProtocol(protocol_, buffer)->readMessageBegin(
+        methodName_, type, seqid_);
+    }
+    catch (const TException&)
+    {
+      return false;
+    }
+
+    if (type != T_CALL || !_readOnlyMethods.count(methodName_))
+      return false;
+
+    const std::size_t argsPos = length_ - buffer->available_read();
+
+    key_ = std::to_string(static_cast<int>(protocol_)) + ':' + methodName_;
+    key_ += ':';
+    key_.append(content_ + argsPos, length_ - argsPos);
+
+    return true;
+  }
+
+  /**
+   * This function returns the serialized message header of a reply.
+   */
+  static std::string messageHeader(
+    Protocol protocol_,
+    const std::string& methodName_,
+    std::int32_t seqid_)
+  {
+    using namespace ::apache::thrift::transport;
+    using namespace ::apache::thrift::protocol;
+
+    std::shared_ptr<TMemoryBuffer> buffer(new TMemoryBuffer(64));
+    createProtocol(protocol_, buffer)->writeMessageBegin(
+      methodName_, T_REPLY, seqid_);
+
+    return buffer->getBufferAsString();
   }
 
   LoggingProcessor _processor;
+
+  std::shared_ptr<ProjectGeneration> _generation;
+  std::set<std::string> _readOnlyMethods;
+  std::shared_ptr<ResultCache> _resultCache;
 };
 
 } // mongoose
@@ -1,7 +1,151 @@
+#include <atomic>
+#include <cstdlib>
+#include <iterator>
+#include <vector>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
 #include <util/util.h>
 #include <util/logutil.h>
 
 #include "mainrequesthandler.h"
+#include "threadedmongoose.h"
+
+namespace
+{
+
+/**
+ * State of a request which is processed by a worker thread. It is shared by
+ * the worker and the connection, because either of them may finish first.
+ */
+struct PendingRequest
+{
+  std::string contentType;
+  std::string content;
+  std::string acceptEncoding;
+  cc::webserver::RequestHandler::Reply reply;
+  std::string etag;
+  std::string contentEncoding;
+  bool failed = false;
+  std::atomic<bool> done{false};
+};
+
+typedef std::shared_ptr<PendingRequest> PendingRequestPtr;
+
+/**
+ * Replies smaller than this are not compressed: the gain would be less than
+ * the cost of compression.
+ */
+const std::size_t minCompressedSize = 1024;
+
+std::string getHeader(mg_connection* conn_, const char* name_)
+{
+  const char* value = mg_get_header(conn_, name_);
+  return value ? value : "";
+}
+
+/**
+ * This function returns the content coding of the reply based on the
+ * Accept-Encoding header of the request, or an empty string if the reply
+ * shouldn't be compressed. Codings with zero quality are refused.
+ */
+std::string selectEncoding(const std::string& acceptEncoding_)
+{
+  std::vector<std::string> codings;
+  boost::split(codings, acceptEncoding_, boost::is_any_of(","));
+
+  bool gzip = false;
+  bool deflate = false;
+
+  for (const std::string& coding : codings)
+  {
+    std::vector<std::string> params;
+    boost::split(params, coding, boost::is_any_of(";"));
+
+    const std::string name = boost::trim_copy(params.front());
+    bool accepted = true;
+
+    for (std::size_t i = 1; i < params.size(); ++i)
+    {
+      std::string param = boost::erase_all_copy(params[i], " ");
+      if (boost::starts_with(param, "q="))
+        accepted = std::strtod(param.c_str() + 2, nullptr) > 0;
+    }
+
+    if (boost::iequals(name, "gzip"))
+      gzip = accepted;
+    else if (boost::iequals(name, "deflate"))
+      deflate = accepted;
+  }
+
+  return gzip ? "gzip" : deflate ? "deflate" : "";
+}
+
+std::string compress(const std::string& content_, const std::string& encoding_)
+{
+  namespace io = boost::iostreams;
+
+  std::string result;
+
+  {
+    io::filtering_ostream out;
+
+    if (encoding_ == "gzip")
+      out.push(io::gzip_compressor());
+    else
+      out.push(io::zlib_compressor());
+
+    out.push(std::back_inserter(result));
+    out.write(content_.data(), content_.size());
+  }
+
+  return result;
+}
+
+/**
+ * This function returns true if the If-None-Match header of the request lists
+ * the given entity tag. Weak comparison is used, because the tag doesn't
+ * depend on the content coding of the reply.
+ */
+bool matchesETag(const std::string& ifNoneMatch_, const std::string& etag_)
+{
+  auto opaque = [](std::string tag_) {
+    boost::trim(tag_);
+    if (boost::starts_with(tag_, "W/"))
+      tag_.erase(0, 2);
+    return tag_;
+  };
+
+  std::vector<std::string> tags;
+  boost::split(tags, ifNoneMatch_, boost::is_any_of(","));
+
+  for (const std::string& tag : tags)
+    if (boost::trim_copy(tag) == "*" || opaque(tag) == opaque(etag_))
+      return true;
+
+  return false;
+}
+
+/**
+ * This function compresses the reply if the client accepts it.
+ */
+void encodeReply(PendingRequest& request_)
+{
+  const std::string& content = request_.reply.content;
+
+  if (content.size() < minCompressedSize)
+    return;
+
+  request_.contentEncoding = selectEncoding(request_.acceptEncoding);
+
+  if (!request_.contentEncoding.empty())
+    request_.reply.content = compress(content, request_.contentEncoding);
+}
+
+}
 
 namespace cc
 {
@@ -18,6 +162,8 @@ int MainRequestHandler::begin_request_handler(struct mg_connection* conn_)
     << ':' << conn_->remote_port << " requested URI: " << uri;
 
   auto handler = pluginHandler.getImplementation(uri);
+  if (handler && scheduler && handler->isAsync())
+    return schedule_request(conn_, handler, uri);
   if (handler)
     return handler->beginRequest(conn_);
 
@@ -32,6 +178,114 @@ int MainRequestHandler::begin_request_handler(struct mg_connection* conn_)
   return MG_FALSE;
 }
 
+int MainRequestHandler::schedule_request(
+  struct mg_connection* conn_,
+  std::shared_ptr<RequestHandler> handler_,
+  const std::string& uri_)
+{
+  // The content of the request is copied, because the buffer of the
+  // connection is reused by Mongoose after this function returns.
+  PendingRequestPtr request = std::make_shared<PendingRequest>();
+  request->content.assign(conn_->content, conn_->content_len);
+
+  request->contentType = getHeader(conn_, "Content-Type");
+  request->acceptEncoding = getHeader(conn_, "Accept-Encoding");
+
+  // If the client already has the reply of a read-only call (i.e. its tag is
+  // listed in If-None-Match) then the call is not processed again.
+  request->etag = handler_->entityTag(request->contentType, request->content);
+
+  const std::string ifNoneMatch = getHeader(conn_, "If-None-Match");
+  if (!request->etag.empty() && !ifNoneMatch.empty() &&
+      matchesETag(ifNoneMatch, request->etag))
+  {
+    mg_send_status(conn_, 304);
+    mg_send_header(conn_, "ETag", request->etag.c_str());
+    mg_write(conn_, "\r\n", 2);
+    return MG_TRUE;
+  }
+
+  conn_->connection_param = new PendingRequestPtr(request);
+  ThreadedMongoose::addPendingRequest();
+
+  scheduler->schedule(uri_, [request, handler_]{
+    try
+    {
+      handler_->processRequest(
+        request->contentType, request->content, request->reply);
+
+      // The reply is encoded here instead of the server thread, so large
+      // replies don't delay the other connections.
+      encodeReply(*request);
+    }
+    catch (const std::exception& ex)
+    {
+      LOG(warning) << ex.what();
+      request->failed = true;
+    }
+    catch (...)
+    {
+      LOG(warning) << "Unknown exception has been caught";
+      request->failed = true;
+    }
+
+    request->done = true;
+  });
+
+  // The reply is sent by poll_request() when the worker has finished.
+  return MG_MORE;
+}
+
+int MainRequestHandler::poll_request(struct mg_connection* conn_)
+{
+  if (!conn_->connection_param)
+    return MG_FALSE;
+
+  PendingRequestPtr request
+    = *static_cast<PendingRequestPtr*>(conn_->connection_param);
+
+  if (!request->done)
+    return MG_FALSE;
+
+  if (request->failed)
+    mg_send_status(conn_, 500);
+
+  const RequestHandler::Reply& reply = request->reply;
+
+  mg_send_header(conn_, "Content-Type", reply.contentType.c_str());
+
+  if (!request->failed)
+  {
+    if (!request->etag.empty())
+      mg_send_header(conn_, "ETag", request->etag.c_str());
+    mg_send_header(conn_, "Vary", "Accept-Encoding");
+  }
+
+  if (!request->contentEncoding.empty())
+    mg_send_header(
+      conn_, "Content-Encoding", request->contentEncoding.c_str());
+
+  mg_send_header(
+    conn_, "Content-Length", std::to_string(reply.content.length()).c_str());
+  mg_write(conn_, "\r\n", 2);
+  mg_write(conn_, reply.content.c_str(), reply.content.length());
+
+  close_request(conn_);
+
+  // Returning MG_TRUE tells mongoose that the request has been served.
+  return MG_TRUE;
+}
+
+void MainRequestHandler::close_request(struct mg_connection* conn_)
+{
+  if (!conn_->connection_param)
+    return;
+
+  delete static_cast<PendingRequestPtr*>(conn_->connection_param);
+  conn_->connection_param = nullptr;
+  ThreadedMongoose::removePendingRequest();
+}
+
 int MainRequestHandler::operator()(
   struct mg_connection* conn_,
   enum mg_event ev_)
@@ -41,8 +295,21 @@ int MainRequestHandler::operator()(
   switch (ev_)
   {
     case MG_REQUEST:
+      // Mongoose repeats this event if more data arrives on the connection
+      // while its request is processed by a worker.
+      if (conn_->connection_param)
+        return MG_MORE;
+
       return begin_request_handler(conn_);
 
+    case MG_POLL:
+      return poll_request(conn_);
+
+    case MG_CLOSE:
+      // The client may close the connection before the reply is ready.
+      close_request(conn_);
+      break;
+
     case MG_AUTH:
     {
       if (digestPasswdFile.empty())
@@ -1,9 +1,13 @@
 #ifndef CC_WEBSERVER_MAINREQUESTHANDLER_H
 #define CC_WEBSERVER_MAINREQUESTHANDLER_H
 
+#include <memory>
+
 #include <webserver/pluginhandler.h>
 #include <webserver/requesthandler.h>
 
+#include "requestscheduler.h"
+
 namespace cc
 {
 namespace webserver
@@ -16,10 +20,23 @@ public:
   std::string digestPasswdFile;
   std::map<std::string, std::string> dataDir;
 
+  /**
+   * Worker pool of the asynchronous request handlers (see
+   * RequestHandler::isAsync()). If it is not set then every request is
+   * processed by the thread of the connection.
+   */
+  std::shared_ptr<RequestScheduler> scheduler;
+
   int operator()(struct mg_connection* conn_, enum mg_event ev_);
 
 private:
   int begin_request_handler(struct mg_connection *conn_);
+  int schedule_request(
+    struct mg_connection *conn_,
+    std::shared_ptr<RequestHandler> handler_,
+    const std::string& uri_);
+  int poll_request(struct mg_connection *conn_);
+  void close_request(struct mg_connection *conn_);
   std::string getDocDirByURI(std::string uri_);
 };
   
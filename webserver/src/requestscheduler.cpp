@@ -0,0 +1,103 @@
+#include <util/logutil.h>
+
+#include "requestscheduler.h"
+
+namespace cc
+{
+namespace webserver
+{
+
+RequestScheduler::RequestScheduler(int numThreads_, int endpointLimit_)
+  : _endpointLimit(endpointLimit_ < 1
+      ? static_cast<std::size_t>(-1)
+      : static_cast<std::size_t>(endpointLimit_)),
+    _stop(false)
+{
+  if (numThreads_ < 1)
+    numThreads_ = 1;
+
+  _threads.reserve(numThreads_);
+
+  for (int i = 0; i < numThreads_; ++i)
+    _threads.emplace_back(&RequestScheduler::worker, this);
+}
+
+RequestScheduler::~RequestScheduler()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+
+  _cond.notify_all();
+
+  for (std::thread& thread : _threads)
+    thread.join();
+}
+
+void RequestScheduler::schedule(const std::string& endpoint_, Job job_)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _queue.push_back(Task{endpoint_, std::move(job_)});
+  }
+
+  _cond.notify_one();
+}
+
+std::deque<RequestScheduler::Task>::iterator RequestScheduler::nextRunnable()
+{
+  for (auto it = _queue.begin(); it != _queue.end(); ++it)
+    if (_running[it->endpoint] < _endpointLimit)
+      return it;
+
+  return _queue.end();
+}
+
+void RequestScheduler::worker()
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+
+  while (true)
+  {
+    std::deque<Task>::iterator it;
+
+    _cond.wait(lock, [&, this]{
+      return _stop || (it = nextRunnable()) != _queue.end();
+    });
+
+    if (_stop)
+      return;
+
+    Task task = std::move(*it);
+    _queue.erase(it);
+    ++_running[task.endpoint];
+
+    lock.unlock();
+
+    try
+    {
+      task.job();
+    }
+    catch (const std::exception& ex)
+    {
+      LOG(warning) << ex.what();
+    }
+    catch (...)
+    {
+      LOG(warning) << "Unknown exception has been caught";
+    }
+
+    lock.lock();
+
+    --_running[task.endpoint];
+
+    // A task waiting for this endpoint may be runnable now. The other workers
+    // are all notified because any of them may wait for that task.
+    if (!_queue.empty())
+      _cond.notify_all();
+  }
+}
+
+} // webserver
+} // cc
@@ -0,0 +1,80 @@
+#ifndef CC_WEBSERVER_REQUESTSCHEDULER_H
+#define CC_WEBSERVER_REQUESTSCHEDULER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace cc
+{
+namespace webserver
+{
+
+/**
+ * Worker pool which processes the requests of the service endpoints, so the
+ * threads running the Mongoose servers are not blocked by slow requests.
+ *
+ * The number of requests processed in parallel is limited per endpoint, so
+ * the slow requests of an endpoint (e.g. diagrams) can't occupy all workers:
+ * the requests of the other endpoints are still served.
+ */
+class RequestScheduler
+{
+public:
+  typedef std::function<void ()> Job;
+
+  /**
+   * @param numThreads_ Number of worker threads.
+   * @param endpointLimit_ Maximal number of requests of an endpoint processed
+   * at the same time. If its value is less than 1 then only the number of
+   * threads limits the requests of an endpoint.
+   */
+  RequestScheduler(int numThreads_, int endpointLimit_);
+
+  /**
+   * Waits for the running jobs and stops the workers. The jobs which haven't
+   * been started are dropped.
+   */
+  ~RequestScheduler();
+
+  /**
+   * This function enqueues a job of the given endpoint. The jobs of the same
+   * endpoint are started in the order of their arrival.
+   */
+  void schedule(const std::string& endpoint_, Job job_);
+
+private:
+  struct Task
+  {
+    std::string endpoint;
+    Job job;
+  };
+
+  void worker();
+
+  /**
+   * Returns the first queued task whose endpoint is under its limit, or the
+   * end of the queue if there is no such task.
+   */
+  std::deque<Task>::iterator nextRunnable();
+
+  const std::size_t _endpointLimit;
+
+  std::mutex _mutex;
+  std::condition_variable _cond;
+  std::deque<Task> _queue;
+  std::map<std::string, std::size_t> _running;
+  bool _stop;
+
+  std::vector<std::thread> _threads;
+};
+
+} // webserver
+} // cc
+
+#endif // CC_WEBSERVER_REQUESTSCHEDULER_H
@@ -22,6 +22,8 @@ const unsigned ThreadedMongoose::DEFAULT_MAX_THREAD;
 
 ThreadedMongoose::Handler ThreadedMongoose::handler;
 
+thread_local int ThreadedMongoose::pendingRequests = 0;
+
 ThreadedMongoose::ThreadedMongoose(int numThreads_) : _numThreads(numThreads_)
 {
 }
@@ -48,11 +50,23 @@ void ThreadedMongoose::signalHandler(int sigNum_)
   ThreadedMongoose::exitFlag = sigNum_;
 }
 
+void ThreadedMongoose::addPendingRequest()
+{
+  ++pendingRequests;
+}
+
+void ThreadedMongoose::removePendingRequest()
+{
+  --pendingRequests;
+}
+
 void* ThreadedMongoose::serve(void* server_)
 {
   while (!exitFlag)
   {
-    mg_poll_server((mg_server*)server_, 1000);
+    mg_poll_server(
+      (mg_server*)server_,
+      pendingRequests ? PENDING_POLL_TIMEOUT_MS : POLL_TIMEOUT_MS);
   }
   
   return nullptr;
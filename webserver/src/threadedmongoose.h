@@ -58,6 +58,16 @@ public:
 
   void run(Handler handler_);
 
+  /**
+   * The event handler calls these functions in the server thread when a
+   * request of the thread is passed to an other thread for processing, and
+   * when its reply has been sent. While a thread has such pending requests,
+   * its server is polled more frequently, so the replies are sent without
+   * waiting for the poll timeout.
+   */
+  static void addPendingRequest();
+  static void removePendingRequest();
+
   template <typename T>
   void run(T* serverData_, Handler handler_)
   {
@@ -141,8 +151,11 @@ private:
   static int delegater(mg_connection *conn_, enum mg_event ev_);
 
   static volatile int exitFlag;
+  static thread_local int pendingRequests;
   static Handler handler;
   static const unsigned DEFAULT_MAX_THREAD = 20u;
+  static const int POLL_TIMEOUT_MS = 1000;
+  static const int PENDING_POLL_TIMEOUT_MS = 5;
 
   std::map<std::string, std::string> _options;
   int _numThreads;
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 
 #include <boost/log/expressions.hpp>
@@ -35,7 +36,17 @@ po::options_description commandLineArguments()
       "Logging level of the parser. Possible values are: debug, info, warning, "
       "error, critical")
     ("jobs,j", po::value<int>()->default_value(4),
-      "Number of worker threads.");
+      "Number of worker threads processing the service requests.")
+    ("endpoint-jobs", po::value<int>(),
+      "Maximal number of requests of a service endpoint processed at the same "
+      "time, so slow requests of a service can't occupy all worker threads. "
+      "By default it is half of the worker threads.")
+    ("io-threads", po::value<int>()->default_value(2),
+      "Number of threads accepting the connections and sending the replies.")
+    ("result-cache-size", po::value<int>()->default_value(32),
+      "Size of the result cache of the language services in MiB per project. "
+      "The cache is cleared when the project is parsed again. 0 disables "
+      "caching.");
 
   return desc;
 }
@@ -97,9 +108,19 @@ int main(int argc, char* argv[])
   cc::webserver::ServerContext ctx(compassRoot, vm);
   requestHandler.pluginHandler.configure(ctx);
 
+  //--- Start request workers ---//
+
+  int jobs = vm["jobs"].as<int>();
+  int endpointJobs = vm.count("endpoint-jobs")
+    ? vm["endpoint-jobs"].as<int>()
+    : std::max(1, jobs / 2);
+
+  requestHandler.scheduler
+    = std::make_shared<cc::webserver::RequestScheduler>(jobs, endpointJobs);
+
   //--- Start mongoose server ---//
 
-  cc::webserver::ThreadedMongoose server(vm["jobs"].as<int>());
+  cc::webserver::ThreadedMongoose server(vm["io-threads"].as<int>());
   server.setOption("listening_port", std::to_string(vm["port"].as<int>()));
   server.setOption("document_root", vm["webguiDir"].as<std::string>());
 
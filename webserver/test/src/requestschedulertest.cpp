@@ -0,0 +1,116 @@
+#define GTEST_HAS_TR1_TUPLE 1
+#define GTEST_USE_OWN_TR1_TUPLE 0
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#include <gtest/gtest.h>
+
+#include "requestscheduler.h"
+
+using namespace cc::webserver;
+
+/**
+ * The jobs of the slow endpoint block until they are released by the test.
+ * The scheduler has four workers, and an endpoint can use two of them.
+ */
+class RequestSchedulerTest : public ::testing::Test
+{
+public:
+  RequestSchedulerTest() :
+    _slowStarted(0),
+    _slowFinished(0),
+    _released(false),
+    _scheduler(4, 2)
+  {
+  }
+
+  ~RequestSchedulerTest()
+  {
+    // The scheduler waits for the running jobs, so they are released even if
+    // the test has failed.
+    release();
+  }
+
+  RequestScheduler::Job slowJob()
+  {
+    return [this]{
+      std::unique_lock<std::mutex> lock(_mutex);
+      ++_slowStarted;
+      _cond.notify_all();
+      _cond.wait(lock, [this]{ return _released; });
+      ++_slowFinished;
+      _cond.notify_all();
+    };
+  }
+
+  void release()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _released = true;
+    _cond.notify_all();
+  }
+
+  /**
+   * This function waits until the predicate holds or the timeout expires.
+   */
+  template <typename Predicate>
+  bool waitFor(
+    Predicate pred_,
+    std::chrono::milliseconds timeout_ = std::chrono::seconds(5))
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _cond.wait_for(lock, timeout_, pred_);
+  }
+
+protected:
+  std::mutex _mutex;
+  std::condition_variable _cond;
+  int _slowStarted;
+  int _slowFinished;
+  bool _released;
+
+  RequestScheduler _scheduler;
+};
+
+TEST_F(RequestSchedulerTest, EndpointLimitTest)
+{
+  for (int i = 0; i < 3; ++i)
+    _scheduler.schedule("slow", slowJob());
+
+  ASSERT_TRUE(waitFor([this]{ return _slowStarted == 2; }));
+
+  // The third job of the endpoint waits even though there are idle workers.
+  EXPECT_FALSE(waitFor(
+    [this]{ return _slowStarted > 2; }, std::chrono::milliseconds(200)));
+
+  release();
+
+  EXPECT_TRUE(waitFor([this]{ return _slowFinished == 3; }));
+}
+
+TEST_F(RequestSchedulerTest, OtherEndpointTest)
+{
+  for (int i = 0; i < 3; ++i)
+    _scheduler.schedule("slow", slowJob());
+
+  ASSERT_TRUE(waitFor([this]{ return _slowStarted == 2; }));
+
+  // The job of the other endpoint is queued after the blocked job of the
+  // slow endpoint, but it is run while the slow endpoint is at its limit.
+  bool fastDone = false;
+
+  _scheduler.schedule("fast", [&, this]{
+    std::lock_guard<std::mutex> lock(_mutex);
+    fastDone = true;
+    _cond.notify_all();
+  });
+
+  EXPECT_TRUE(waitFor([&]{ return fastDone; }));
+  EXPECT_EQ(2, _slowStarted);
+
+  release();
+
+  EXPECT_TRUE(waitFor([this]{ return _slowFinished == 3; }));
+}
@@ -0,0 +1,111 @@
+#define GTEST_HAS_TR1_TUPLE 1
+#define GTEST_USE_OWN_TR1_TUPLE 0
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include <boost/filesystem.hpp>
+
+#include <gtest/gtest.h>
+
+#include <webserver/resultcache.h>
+
+using namespace cc::webserver;
+
+namespace fs = boost::filesystem;
+
+class ResultCacheTest : public ::testing::Test
+{
+public:
+  ResultCacheTest() :
+    _generationFile(fs::temp_directory_path() / fs::unique_path())
+  {
+    std::ofstream(_generationFile.string()) << "{}";
+  }
+
+  ~ResultCacheTest()
+  {
+    boost::system::error_code ec;
+    fs::remove(_generationFile, ec);
+  }
+
+protected:
+  fs::path _generationFile;
+};
+
+TEST_F(ResultCacheTest, GetStoredValueTest)
+{
+  ResultCache cache(_generationFile.string(), 100);
+  std::string value;
+
+  EXPECT_FALSE(cache.get("a", value));
+
+  cache.put("a", "alpha");
+  ASSERT_TRUE(cache.get("a", value));
+  EXPECT_EQ("alpha", value);
+
+  cache.put("a", "another");
+  ASSERT_TRUE(cache.get("a", value));
+  EXPECT_EQ("another", value);
+}
+
+TEST_F(ResultCacheTest, LeastRecentlyUsedEvictionTest)
+{
+  // Every entry takes 5 bytes, so two of them fit.
+  ResultCache cache(_generationFile.string(), 10);
+  std::string value;
+
+  cache.put("a", "1111");
+  cache.put("b", "2222");
+
+  // The lookup makes "a" the most recently used entry, so "b" is evicted.
+  ASSERT_TRUE(cache.get("a", value));
+  cache.put("c", "3333");
+
+  EXPECT_FALSE(cache.get("b", value));
+  EXPECT_TRUE(cache.get("a", value));
+  EXPECT_TRUE(cache.get("c", value));
+
+  // A larger entry evicts as many entries as needed.
+  cache.put("d", "444444444");
+
+  EXPECT_FALSE(cache.get("a", value));
+  EXPECT_FALSE(cache.get("c", value));
+  ASSERT_TRUE(cache.get("d", value));
+  EXPECT_EQ("444444444", value);
+}
+
+TEST_F(ResultCacheTest, TooLargeValueTest)
+{
+  ResultCache cache(_generationFile.string(), 10);
+  std::string value;
+
+  cache.put("a", "1111");
+  cache.put("b", "0123456789");
+
+  EXPECT_FALSE(cache.get("b", value));
+  EXPECT_TRUE(cache.get("a", value));
+}
+
+TEST_F(ResultCacheTest, GenerationResetTest)
+{
+  ResultCache cache(_generationFile.string(), 100);
+  std::string value;
+
+  cache.put("a", "alpha");
+  ASSERT_TRUE(cache.get("a", value));
+
+  // Reparsing rewrites the generation file. The file is checked at most once
+  // per second.
+  fs::last_write_time(_generationFile,
+    fs::last_write_time(_generationFile) + 10);
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+
+  EXPECT_FALSE(cache.get("a", value));
+
+  cache.put("a", "again");
+  ASSERT_TRUE(cache.get("a", value));
+  EXPECT_EQ("again", value);
+}